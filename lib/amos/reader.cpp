@@ -2,6 +2,7 @@
 #include "reader.h"
 
 #include <cassert>
+#include <climits>
 #include <cstring>
 
 #define BUFF_SIZE 4096
@@ -17,7 +18,34 @@ namespace AMOS {
   };
 
   int get_reads(std::vector<Read*>& container, const char* afg_filename) {
+    return get_reads(container, afg_filename, 0, INT_MAX);
+  }
+
+  int count_reads(const char* afg_filename) {
+    int records = 0;
+
+    FILE *fd = fopen(afg_filename, "r");
+    if (fd == nullptr) {
+      return -1;
+    }
+
+    // lines longer than the buffer are read in parts, and no part but the first starts a record
+    char line[BUFF_SIZE] = {0};
+    bool line_start = true;
+    while (fgets(line, BUFF_SIZE, fd) != nullptr) {
+      if (line_start && strncmp(line, "{RED", 4) == 0) {
+        records++;
+      }
+      line_start = strchr(line, '\n') != nullptr;
+    }
+
+    fclose(fd);
+    return records;
+  }
+
+  int get_reads(std::vector<Read*>& container, const char* afg_filename, int first, int last) {
     int records = 0;
+    int kept = 0;
 
     FILE *fd = fopen(afg_filename, "r");
     if (fd == nullptr) {
@@ -64,7 +92,12 @@ namespace AMOS {
             state = IN_READ;
           } else if (line[0] == '}') {
             state = OUT;
-            container.push_back(curr_read);
+            if (records >= first && records < last) {
+              container.push_back(curr_read);
+              kept++;
+            } else {
+              delete curr_read;
+            }
             curr_read = new Read();
             records++;
           }
@@ -92,6 +125,6 @@ namespace AMOS {
     delete curr_read;
 
     fclose(fd);
-    return records;
+    return kept;
   }
 }
@@ -10,6 +10,12 @@
 namespace AMOS {
 
   int get_reads(std::vector<Read*>& container, const char* afg_filename);
+
+  // keeps only the reads from first to last (exclusive), counted from 0 in the order of the file
+  int get_reads(std::vector<Read*>& container, const char* afg_filename, int first, int last);
+
+  // number of reads in the file, none of them kept
+  int count_reads(const char* afg_filename);
 }
 
 #endif
@@ -0,0 +1,203 @@
+#include "ovb.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace OVB {
+
+  static void put_u32(char* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+      out[i] = (value >> (8 * i)) & 0xff;
+    }
+  }
+
+  static void put_u64(char* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+      out[i] = (value >> (8 * i)) & 0xff;
+    }
+  }
+
+  static uint32_t get_u32(const char* in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+      value |= (uint32_t) (uint8_t) in[i] << (8 * i);
+    }
+    return value;
+  }
+
+  static uint64_t get_u64(const char* in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+      value |= (uint64_t) (uint8_t) in[i] << (8 * i);
+    }
+    return value;
+  }
+
+  void encode_header(const Header& header, char* out) {
+    memcpy(out, "OVB1", 4);
+    put_u32(out + 4, VERSION);
+    put_u32(out + 8, header.reads);
+    put_u32(out + 12, RECORD_SIZE);
+    put_u64(out + 16, header.overlaps);
+    put_u64(out + 24, header.checksum);
+  }
+
+  bool decode_header(const char* in, Header* header) {
+    if (memcmp(in, "OVB1", 4) != 0) return false;
+    if (get_u32(in + 4) != VERSION || get_u32(in + 12) != (uint32_t) RECORD_SIZE) return false;
+
+    header->reads = get_u32(in + 8);
+    header->overlaps = get_u64(in + 16);
+    header->checksum = get_u64(in + 24);
+    return true;
+  }
+
+  void encode_overlap(const Overlap& overlap, char* out) {
+    put_u32(out, overlap.read_one);
+    put_u32(out + 4, overlap.read_two);
+    put_u32(out + 8, overlap.score);
+    put_u32(out + 12, overlap.a_hang);
+    put_u32(out + 16, overlap.b_hang);
+    out[20] = overlap.adj;
+    out[21] = out[22] = out[23] = 0;
+  }
+
+  void decode_overlap(const char* in, Overlap* overlap) {
+    overlap->read_one = get_u32(in);
+    overlap->read_two = get_u32(in + 4);
+    overlap->score = get_u32(in + 8);
+    overlap->a_hang = get_u32(in + 12);
+    overlap->b_hang = get_u32(in + 16);
+    overlap->adj = in[20];
+  }
+
+  uint64_t record_checksum(const char* record) {
+    uint64_t hash = 14695981039346656037ull;
+    for (int i = 0; i < RECORD_SIZE; ++i) {
+      hash = (hash ^ (uint8_t) record[i]) * 1099511628211ull;
+    }
+    return hash;
+  }
+
+  int write_header(int fd, const Header& header) {
+    char buffer[HEADER_SIZE];
+    encode_header(header, buffer);
+    return pwrite(fd, buffer, HEADER_SIZE, 0) == HEADER_SIZE ? 0 : -1;
+  }
+
+  Writer::Writer() : _fd(nullptr) {}
+
+  Writer::~Writer() {
+    if (_fd != nullptr) {
+      close();
+    }
+  }
+
+  int Writer::open(const char* filename, uint32_t reads) {
+    _fd = fopen(filename, "wb");
+    if (_fd == nullptr) {
+      return -1;
+    }
+    _filename = filename;
+
+    _header = Header();
+    _header.reads = reads;
+
+    // the real header is written on close
+    char buffer[HEADER_SIZE];
+    encode_header(_header, buffer);
+    fwrite(buffer, 1, HEADER_SIZE, _fd);
+    return 0;
+  }
+
+  void Writer::write(const Overlap& overlap) {
+    char record[RECORD_SIZE];
+    encode_overlap(overlap, record);
+    fwrite(record, 1, RECORD_SIZE, _fd);
+
+    _header.overlaps++;
+    _header.checksum += record_checksum(record);
+  }
+
+  int Writer::close() {
+    // records that did not all make it get no header
+    int result = -1;
+    if (fflush(_fd) == 0 && !ferror(_fd)) {
+      result = write_header(fileno(_fd), _header);
+    }
+    if (fclose(_fd) != 0) {
+      result = -1;
+    }
+    _fd = nullptr;
+    return result;
+  }
+
+  void Writer::discard() {
+    fclose(_fd);
+    _fd = nullptr;
+    unlink(_filename.c_str());
+  }
+
+  Reader::Reader() : _data(nullptr), _length(0) {}
+
+  Reader::~Reader() {
+    close();
+  }
+
+  int Reader::open(const char* filename) {
+    int fd = ::open(filename, O_RDONLY);
+    if (fd < 0) {
+      return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < HEADER_SIZE) {
+      ::close(fd);
+      return -1;
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      return -1;
+    }
+
+    _data = (const char*) data;
+    _length = st.st_size;
+
+    if (!decode_header(_data, &_header) ||
+        _length != HEADER_SIZE + _header.overlaps * RECORD_SIZE) {
+      close();
+      return -1;
+    }
+
+    // records are read front to back
+    madvise((void*) _data, _length, MADV_SEQUENTIAL);
+    return 0;
+  }
+
+  void Reader::close() {
+    if (_data != nullptr) {
+      munmap((void*) _data, _length);
+      _data = nullptr;
+      _length = 0;
+    }
+  }
+
+  Overlap Reader::get(uint64_t i) const {
+    Overlap overlap;
+    decode_overlap(_data + HEADER_SIZE + i * RECORD_SIZE, &overlap);
+    return overlap;
+  }
+
+  bool Reader::verify() const {
+    uint64_t checksum = 0;
+    for (uint64_t i = 0; i < _header.overlaps; ++i) {
+      checksum += record_checksum(_data + HEADER_SIZE + i * RECORD_SIZE);
+    }
+    return checksum == _header.checksum;
+  }
+}
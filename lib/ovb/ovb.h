@@ -0,0 +1,118 @@
+#ifndef _OVB_OVB_H
+#define _OVB_OVB_H
+
+// Binary overlap format (.ovb), the binary counterpart of AFG OVL records.
+//
+// All integers are little-endian. A 32-byte header
+//
+//   0  magic "OVB1"
+//   4  uint32 version (1)
+//   8  uint32 number of reads the overlaps refer to (0 if unknown)
+//  12  uint32 record size (24)
+//  16  uint64 number of overlaps
+//  24  uint64 checksum, the sum of checksums of all records
+//
+// is followed by fixed-width records
+//
+//   0  int32 read one (iid)
+//   4  int32 read two (iid)
+//   8  int32 score
+//  12  int32 a hang
+//  16  int32 b hang
+//  20  uint8 adjacency, 'N' or 'I'
+//  21  3 zero bytes
+//
+// The checksum does not depend on the order of records, so threads can write them in any order.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace OVB {
+
+  const int HEADER_SIZE = 32;
+  const int RECORD_SIZE = 24;
+  const uint32_t VERSION = 1;
+
+  typedef struct Header {
+    uint32_t reads;
+    uint64_t overlaps;
+    uint64_t checksum;
+
+    Header() : reads(0), overlaps(0), checksum(0) {}
+  } Header;
+
+  typedef struct Overlap {
+    int32_t read_one;
+    int32_t read_two;
+    int32_t score;
+    int32_t a_hang;
+    int32_t b_hang;
+    char adj;
+  } Overlap;
+
+  void encode_header(const Header& header, char* out);
+  // false if it is not a header of a supported version
+  bool decode_header(const char* in, Header* header);
+
+  void encode_overlap(const Overlap& overlap, char* out);
+  void decode_overlap(const char* in, Overlap* overlap);
+
+  // FNV-1a of an encoded record
+  uint64_t record_checksum(const char* record);
+
+  // writes the header at the start of the file descriptor, which has to be seekable
+  int write_header(int fd, const Header& header);
+
+  // Writes records one by one, keeping count and checksum for the header.
+  class Writer {
+   public:
+    Writer();
+    ~Writer();
+
+    // -1 if the file cannot be created
+    int open(const char* filename, uint32_t reads);
+    void write(const Overlap& overlap);
+    // writes the final header and closes the file; -1 if any record or the header
+    // could not be written
+    int close();
+    // closes the file without a header and removes it, for output that cannot be completed
+    void discard();
+
+   private:
+    FILE* _fd;
+    std::string _filename;
+    Header _header;
+  };
+
+  // Maps an .ovb file into memory; records are decoded on access.
+  class Reader {
+   public:
+    Reader();
+    ~Reader();
+
+    // -1 if the file cannot be mapped or its header or size are wrong
+    int open(const char* filename);
+    void close();
+
+    const Header& header() const {
+      return _header;
+    }
+
+    uint64_t size() const {
+      return _header.overlaps;
+    }
+
+    Overlap get(uint64_t i) const;
+
+    // recomputes the checksum of all records and compares it with the header
+    bool verify() const;
+
+   private:
+    const char* _data;
+    uint64_t _length;
+    Header _header;
+  };
+}
+
+#endif
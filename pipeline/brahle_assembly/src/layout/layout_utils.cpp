@@ -11,6 +11,7 @@
 #include <unordered_map>
 
 #include "lib/amos/reader.cpp"
+#include "lib/ovb/ovb.cpp"
 
 #include "layout/layout_utils.h"
 
@@ -75,6 +76,49 @@ namespace layout {
     return records;
   }
 
+  /**
+   * Adds an overlap between reads given by their orig_ids, the same for every input format.
+   */
+  void _AddOverlap(
+      overlap::ReadSet* read_set,
+      ReadIdMap& internal_id,
+      overlap::OverlapSet* overlap_set,
+      char type,
+      int read_one,
+      int read_two,
+      int hang_one,
+      int hang_two) {
+
+    if (!internal_id.count(read_one)) {
+      fprintf(stderr, "Read with orig_id '%d' has not been found\n", read_one);
+      exit(3);
+    }
+
+    if (!internal_id.count(read_two)) {
+      fprintf(stderr, "Read with orig_id '%d' has not been found\n", read_two);
+      exit(3);
+    }
+
+    if (type != 'N' && type != 'I') {
+      fprintf(stderr, "Unkown overlap type '%c'\n", type);
+      exit(3);
+    }
+
+    read_one = internal_id[read_one];
+    read_two = internal_id[read_two];
+
+    std::pair<int, int> lenghts = getOverlapLengths(read_set, read_one, read_two, hang_one, hang_two);
+    overlap_set->Add(new overlap::Overlap(
+          read_one,
+          read_two,
+          lenghts.first,
+          lenghts.second,
+          hang_one,
+          hang_two,
+          type == 'N' ? overlap::Overlap::Type::EB : overlap::Overlap::Type::EE,
+          0));
+  }
+
   overlap::OverlapSet* ReadOverlapsAfg(overlap::ReadSet* read_set, FILE *fd) {
     clock_t start = clock();
 
@@ -96,35 +140,40 @@ namespace layout {
           &score,
           &hang_one,
           &hang_two) == 6) {
+      _AddOverlap(read_set, internal_id, overlap_set, type, read_one, read_two, hang_one, hang_two);
+    }
+    printf(
+        "Overlaps read in %.2lfs\n",
+        (clock() - start)/static_cast<double>(CLOCKS_PER_SEC));
+    return overlap_set;
+  }
 
-      if (!internal_id.count(read_one)) {
-        fprintf(stderr, "Read with orig_id '%d' has not been found\n", read_one);
-        exit(3);
-      }
+  overlap::OverlapSet* ReadOverlapsOvb(overlap::ReadSet* read_set, const char *filename) {
+    clock_t start = clock();
 
-      if (!internal_id.count(read_two)) {
-        fprintf(stderr, "Read with orig_id '%d' has not been found\n", read_two);
-        exit(3);
-      }
+    OVB::Reader reader;
+    if (reader.open(filename) != 0) {
+      fprintf(stderr, "File '%s' is not a valid .ovb file\n", filename);
+      exit(3);
+    }
 
-      if (type != 'N' && type != 'I') {
-        fprintf(stderr, "Unkown overlap type '%c'\n", type);
-        exit(3);
-      }
+    if (reader.header().reads != 0 && reader.header().reads != (uint32_t) read_set->size()) {
+      fprintf(stderr, "Overlaps are for %u reads, but there are %u\n",
+          reader.header().reads, (uint32_t) read_set->size());
+      exit(3);
+    }
+
+    if (!reader.verify()) {
+      fprintf(stderr, "Checksum of '%s' does not match its header\n", filename);
+      exit(3);
+    }
+
+    ReadIdMap internal_id = _MapIds(read_set);
 
-      read_one = internal_id[read_one];
-      read_two = internal_id[read_two];
-
-      std::pair<int, int> lenghts = getOverlapLengths(read_set, read_one, read_two, hang_one, hang_two);
-      overlap_set->Add(new overlap::Overlap(
-            read_one,
-            read_two,
-            lenghts.first,
-            lenghts.second,
-            hang_one,
-            hang_two,
-            type == 'N' ? overlap::Overlap::Type::EB : overlap::Overlap::Type::EE,
-            0));
+    overlap::OverlapSet* overlap_set = new overlap::OverlapSet(reader.size());
+    for (uint64_t i = 0; i < reader.size(); ++i) {
+      OVB::Overlap o = reader.get(i);
+      _AddOverlap(read_set, internal_id, overlap_set, o.adj, o.read_one, o.read_two, o.a_hang, o.b_hang);
     }
     printf(
         "Overlaps read in %.2lfs\n",
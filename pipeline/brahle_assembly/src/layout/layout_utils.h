@@ -23,6 +23,12 @@ namespace layout {
    */
   overlap::OverlapSet* ReadOverlapsAfg(overlap::ReadSet* read_set, FILE *fd);
 
+  /**
+   * Reads all overlaps from the binary .ovb file (see lib/ovb/ovb.h), checking
+   * its read count and checksum.
+   */
+  overlap::OverlapSet* ReadOverlapsOvb(overlap::ReadSet* read_set, const char *filename);
+
   /**
    * Finds the n50 of the given contig set.
    * http://en.wikipedia.org/wiki/N50_statistic
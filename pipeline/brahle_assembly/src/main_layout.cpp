@@ -44,7 +44,7 @@ char *overlaps_file_name = nullptr;
 void usage(char *argv[]) {
   fprintf(
       stderr,
-      "Usage: %s <reads_file> <overlaps_file.afg>\n",
+      "Usage: %s <reads_file> <overlaps_file.afg|overlaps_file.ovb>\n",
       argv[0]);
   fprintf(stderr, "\n");
   fprintf(stderr, "Flags\n");
@@ -79,7 +79,7 @@ void setup_cmd_interface(int argc, char **argv) {
   parsero::add_argument("reads.afg",
     [] (char *filename) { reads_file_name = filename; });
 
-  parsero::add_argument("overlaps.afg",
+  parsero::add_argument("overlaps.afg|overlaps.ovb",
     [] (char *filename) { overlaps_file_name = filename; });
 
   parsero::parse(argc, argv);
@@ -97,7 +97,12 @@ int main(int argc, char *argv[]) {
   FILE *overlaps_file = nullptr;
   FILE *graphviz_file = nullptr;
 
-  if (strlen(overlaps_file_name)) {
+  // binary overlaps are mapped by the reader itself
+  size_t overlaps_name_len = strlen(overlaps_file_name);
+  bool binary_overlaps = overlaps_name_len > 4 &&
+    strcmp(overlaps_file_name + overlaps_name_len - 4, ".ovb") == 0;
+
+  if (strlen(overlaps_file_name) && !binary_overlaps) {
     overlaps_file = fopen(overlaps_file_name, "r");
     if (overlaps_file == nullptr) {
       fprintf(
@@ -130,7 +135,10 @@ int main(int argc, char *argv[]) {
 
   // getting overlaps
   std::shared_ptr< overlap::OverlapSet > overlaps;
-  if (strlen(overlaps_file_name) > 0) {
+  if (binary_overlaps) {
+    fprintf(stderr, "Reading overlaps from ovb file '%s'\n", overlaps_file_name);
+    overlaps.reset(layout::ReadOverlapsOvb(&reads, overlaps_file_name));
+  } else if (strlen(overlaps_file_name) > 0) {
     fprintf(stderr, "Reading overlaps from afg file '%s'\n", overlaps_file_name);
     overlaps.reset(layout::ReadOverlapsAfg(&reads, overlaps_file));
   } else {
@@ -5,7 +5,8 @@
 #include <cassert>
 #include <cstring>
 #include <climits>
-#define NEG_INF (INT_MIN + 100)
+#include <cstdint>
+#include <vector>
 
 char match_score[4][4] = {
     { MATCH_SCORE,    MISMATCH_SCORE, MISMATCH_SCORE, MISMATCH_SCORE },
@@ -14,15 +15,6 @@ char match_score[4][4] = {
     { MISMATCH_SCORE, MISMATCH_SCORE, MISMATCH_SCORE, MATCH_SCORE }
 };
 
-int translate_letter(const char c) {
-
-    if (c == 'A')   return 0;
-    if (c == 'C')   return 1;
-    if (c == 'G')   return 2;
-    if (c == 'T')   return 3;
-    return -1;
-}
-
 void set_pair(std::pair<int, int>* pair, int first, int second) {
 
     pair->first = first;
@@ -61,50 +53,55 @@ int max(int a, int b, int* index) {
     }
 }
 
-overlap_band_t::overlap_band_t(int height, int width) : width(width), height(height), best_score(NEG_INF) {
+// cell on the top or left border of the matrix that lies on the given diagonal (col - row)
+std::pair<int, int> border_cell(int diagonal) {
 
-    gapa_curr = new int[width];
-    middle_prev = new int[width];
-    middle_curr = new int[width];
-    gapb_curr = new int[width];
-
-    gapa_start = new std::pair<int, int>[width];
-    middle_prev_start = new std::pair<int, int>[width];
-    middle_curr_start = new std::pair<int, int>[width];
-    gapb_start = new std::pair<int, int>[width];
+    if (diagonal >= 0)  return std::make_pair(0, diagonal);
+    return std::make_pair(-diagonal, 0);
 }
 
-overlap_band_t::~overlap_band_t() {
+overlap_drop_t::overlap_drop_t(double max_error_rate) {
+
+    rate = -(INDEL_SCORE + GAP_SCORE + MISMATCH_SCORE) * max_error_rate;
 
-    delete[] gapa_curr;
-    delete[] middle_prev;
-    delete[] middle_curr;
-    delete[] gapb_curr;
+    // a gap base costs 1/2 of length and -INDEL_SCORE of score, the cheapest mix of gaps and
+    // matches to keep x rows apart from the score of x matches costs gap_cost per score missing
+    gap_cost = ((1 - rate) / 2 - INDEL_SCORE + rate) / (1 - INDEL_SCORE);
 
-    delete[] gapa_start;
-    delete[] middle_prev_start;
-    delete[] middle_curr_start;
-    delete[] gapb_start;
+    // with higher rates a longer path is not always worse
+    enabled = rate < 1;
 }
 
-void overlap_band_t::initialize(int start_row, int height) {
+overlap_band_t::overlap_band_t()
+    : d_min(0), width(0), height(0), blen(0), track_start(true), best_score(NEG_INF) {
+}
 
+void overlap_band_t::initialize(int start_row, int height, int blen, int d_min, int d_max, bool track_start) {
+
+    // diagonals outside of the matrix behave exactly like its edges
+    d_min = std::max(d_min, -(height - 1));
+    d_max = std::min(d_max, blen);
+
+    this->d_min = d_min;
+    this->width = std::max(d_max - d_min + 1, 0);
     this->height = height;
+    this->blen = blen;
+    this->track_start = track_start;
 
     int init_value = start_row == 1 ? 0 : NEG_INF;
 
     // forbids using upper row for calculating the current one,
-    // or allows skipping arbitrary number of characters if it is the first row
-    for (int i = 0; i < width; ++i) {
-
-        gapb_curr[i] = init_value;
-        set_pair(&gapb_start[i], start_row - 1, i);
-
-        middle_prev[i] = init_value;
-        set_pair(&middle_prev_start[i], start_row - 1, i);
-
-        gapa_curr[i] = init_value;
-        set_pair(&gapa_start[i], start_row - 1, i);
+    // or allows skipping arbitrary number of characters if it is the first row;
+    // one more diagonal right of the band is always NEG_INF
+    gapa.assign(width + 1, init_value);
+    middle.assign(width + 1, init_value);
+
+    if (track_start) {
+        gapa_start.resize(width + 1);
+        middle_start.resize(width + 1);
+        for (int k = 0; k <= width; ++k) {
+            gapa_start[k] = middle_start[k] = d_min + k;
+        }
     }
 
     best_score = NEG_INF;
@@ -114,64 +111,107 @@ void overlap_band_t::initialize(int start_row, int height) {
 
 void overlap_band_t::update_band(int lo, int hi, int row, const char *a, const char *b) {
 
-    int ca, cb, max_index;
+    int klo = lo - row - d_min;
+    int khi = hi - row - d_min;
+    int ca = a[row - 1];
+    int max_index;
 
     // allows skipping arbitrary number of characters in first string
-    middle_prev[0] = 0;
-    set_pair(&middle_prev_start[0], row - 1, 0);
-
-    // ensures that gapb won't use any field from last step that wasn't involved in band
-    gapb_curr[lo - 1] = NEG_INF;
-    middle_curr[lo - 1] = NEG_INF;
+    if (lo == 1) {
+        middle[klo] = 0;
+        middle_start[klo] = -(row - 1);
+    }
 
     // ensures that gapa won't use any field from last step that wasn't involved in band
-    gapa_curr[hi] = NEG_INF;
-    middle_prev[hi] = NEG_INF;
+    gapa[khi + 1] = NEG_INF;
+    middle[khi + 1] = NEG_INF;
 
-    for (int col = lo; col <= hi; ++col) {
+    // cell left of the current one, outside of the band at first
+    int gapb = NEG_INF, gapb_from = 0;
+    int left = NEG_INF, left_from = 0;
 
-        ca = translate_letter(a[row - 1]);
-        cb = translate_letter(b[col - 1]);
+    // the row is updated in place, lanes k and k + 1 still hold the previous row when k is reached
+    for (int k = klo; k <= khi; ++k) {
 
-        gapb_curr[col] = max(gapb_curr[col - 1] + INDEL_SCORE, middle_curr[col - 1] + INDEL_SCORE + GAP_SCORE, &max_index);
-        if (max_index == 0) gapb_start[col] = gapb_start[col - 1];
-        else                gapb_start[col] = middle_curr_start[col - 1];
+        int cb = b[row + d_min + k - 1];
 
-        gapa_curr[col] = max(gapa_curr[col] + INDEL_SCORE, middle_prev[col] + INDEL_SCORE + GAP_SCORE, &max_index);
-        if (max_index == 1) gapa_start[col] = middle_prev_start[col];
+        gapb = max(gapb + INDEL_SCORE, left + INDEL_SCORE + GAP_SCORE, &max_index);
+        if (max_index == 1) gapb_from = left_from;
 
-        middle_curr[col] = max(middle_prev[col - 1] + match_score[ca][cb], gapa_curr[col], gapb_curr[col], &max_index);
-        if (max_index == 0)         middle_curr_start[col] = middle_prev_start[col - 1];
-        else if (max_index == 1)    middle_curr_start[col] = gapa_start[col];
-        else                        middle_curr_start[col] = gapb_start[col];
+        int gapa_score = max(gapa[k + 1] + INDEL_SCORE, middle[k + 1] + INDEL_SCORE + GAP_SCORE, &max_index);
+        int gapa_from = max_index == 1 ? middle_start[k + 1] : gapa_start[k + 1];
+
+        left = max(middle[k] + match_score[ca][cb], gapa_score, gapb, &max_index);
+        if (max_index == 0)         left_from = middle_start[k];
+        else if (max_index == 1)    left_from = gapa_from;
+        else                        left_from = gapb_from;
+
+        gapa[k] = gapa_score;
+        gapa_start[k] = gapa_from;
+        middle[k] = left;
+        middle_start[k] = left_from;
     }
 
-    if (hi == width - 1) {
-        if (middle_curr[hi] > best_score) {
-            best_score = middle_curr[hi];
-            best_start = middle_curr_start[hi];
+    if (hi == blen) {
+        if (middle[khi] > best_score) {
+            best_score = middle[khi];
+            best_start = border_cell(middle_start[khi]);
             set_pair(&best_end, row, hi);
         }
     }
 
     if (row == height - 1) {
-        for (int col = lo; col <= hi; ++col) {
-            if (middle_curr[col] > best_score) {
-                best_score = middle_curr[col];
-                best_start = middle_curr_start[col];
-                set_pair(&best_end, row, col);
+        for (int k = klo; k <= khi; ++k) {
+            if (middle[k] > best_score) {
+                best_score = middle[k];
+                best_start = border_cell(middle_start[k]);
+                set_pair(&best_end, row, row + d_min + k);
             }
         }
     }
+}
+
+void overlap_band_t::update_band_score(int lo, int hi, int row, const char *a, const char *b) {
+
+    // same as update_band, just without following where the overlap started
+    int klo = lo - row - d_min;
+    int khi = hi - row - d_min;
+    int ca = a[row - 1];
+
+    if (lo == 1) middle[klo] = 0;
+
+    gapa[khi + 1] = NEG_INF;
+    middle[khi + 1] = NEG_INF;
+
+    int gapb = NEG_INF, left = NEG_INF;
+
+    for (int k = klo; k <= khi; ++k) {
+
+        int cb = b[row + d_min + k - 1];
+
+        gapb = std::max(gapb + INDEL_SCORE, left + INDEL_SCORE + GAP_SCORE);
+        int gapa_score = std::max(gapa[k + 1] + INDEL_SCORE, middle[k + 1] + INDEL_SCORE + GAP_SCORE);
+        left = std::max(middle[k] + match_score[ca][cb], std::max(gapa_score, gapb));
+
+        gapa[k] = gapa_score;
+        middle[k] = left;
+    }
 
-    // swaps current and prev buffer
-    int *tmp = middle_curr;
-    middle_curr = middle_prev;
-    middle_prev = tmp;
+    if (hi == blen) {
+        if (middle[khi] > best_score) {
+            best_score = middle[khi];
+            set_pair(&best_end, row, hi);
+        }
+    }
 
-    std::pair<int, int>* tmp_pair = middle_curr_start;
-    middle_curr_start = middle_prev_start;
-    middle_prev_start = tmp_pair;
+    if (row == height - 1) {
+        for (int k = klo; k <= khi; ++k) {
+            if (middle[k] > best_score) {
+                best_score = middle[k];
+                set_pair(&best_end, row, row + d_min + k);
+            }
+        }
+    }
 }
 
 char** create_char_matrix(int r, int c) {
@@ -210,7 +250,7 @@ int local_alignment(const char* a, int alen, const char* b, int blen, std::pair<
     // calculate score
     for (int i = 1; i < alen + 1; ++i) {
         for (int j = 1; j < blen + 1; ++j) {
-            int ca = translate_letter(a[i - 1]), cb = translate_letter(b[j - 1]);
+            int ca = a[i - 1], cb = b[j - 1];
             int match = score[i-1][j-1] + match_score[ca][cb];
             int gapa = score[i][j-1] - 3;
             int gapb = score[i-1][j] - 3;
@@ -294,7 +334,7 @@ int overlap_alignment(const char* a, int alen, const char* b, int blen,
     // calculate score
     for (int i = 1; i < alen + 1; ++i) {
         for (int j = 1; j < blen + 1; ++j) {
-            int ca = translate_letter(a[i - 1]), cb = translate_letter(b[j - 1]);
+            int ca = a[i - 1], cb = b[j - 1];
             int match = score[i-1][j-1] + match_score[ca][cb];
             int gapa = score[i][j-1] - 3;
             int gapb = score[i-1][j] - 3;
@@ -406,15 +446,15 @@ int banded_overlap2(const char* a, int alen, const char* b, int blen, int d_min,
         if (lo == hi) {
             if (lo == 1) {
                 // band is on the left edge of matrix, we just use upper left field
-                ca = translate_letter(a[i - 1]);
-                cb = translate_letter(b[lo - 1]);
+                ca = a[i - 1];
+                cb = b[lo - 1];
                 match = score[i-1][lo-1] + match_score[ca][cb];
                 score[i][lo] = match;
                 backtrack[i][lo] = 'M';
             } else {
                 // band is on the right edge of matrix, we just use upper left and upper field
-                ca = translate_letter(a[i - 1]);
-                cb = translate_letter(b[hi - 1]);
+                ca = a[i - 1];
+                cb = b[hi - 1];
                 match = score[i-1][hi-1] + match_score[ca][cb];
                 gapb = score[i-1][hi] + MISMATCH_SCORE;
 
@@ -430,8 +470,8 @@ int banded_overlap2(const char* a, int alen, const char* b, int blen, int d_min,
         }
 
         // calculate first field in the band
-        ca = translate_letter(a[i - 1]);
-        cb = translate_letter(b[lo - 1]);
+        ca = a[i - 1];
+        cb = b[lo - 1];
         match = score[i-1][lo-1] + match_score[ca][cb];
         gapb = score[i-1][lo] + MISMATCH_SCORE;
 
@@ -445,7 +485,7 @@ int banded_overlap2(const char* a, int alen, const char* b, int blen, int d_min,
 
         // first and last in band are calculated on different way
         for (int j = lo + 1; j < hi; ++j) {
-            ca = translate_letter(a[i - 1]), cb = translate_letter(b[j - 1]);
+            ca = a[i - 1], cb = b[j - 1];
             match = score[i-1][j-1] + match_score[ca][cb];
             gapa = score[i][j-1] + MISMATCH_SCORE;
             gapb = score[i-1][j] + MISMATCH_SCORE;
@@ -465,8 +505,8 @@ int banded_overlap2(const char* a, int alen, const char* b, int blen, int d_min,
         }
 
         // calculate last field in the band
-        ca = translate_letter(a[i - 1]);
-        cb = translate_letter(b[hi - 1]);
+        ca = a[i - 1];
+        cb = b[hi - 1];
         match = score[i-1][hi-1] + match_score[ca][cb];
         gapa = score[i][hi-1] + MISMATCH_SCORE;
 
@@ -546,17 +586,22 @@ int banded_overlap2(const char* a, int alen, const char* b, int blen, int d_min,
 
 
 int banded_overlap(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
-        std::pair<int, int>* start, std::pair<int, int>* end) {
+        std::pair<int, int>* start, std::pair<int, int>* end, double max_error_rate) {
 
-    overlap_band_t band(alen + 1, blen + 1);
+    // every thread (e.g. a ThreadPool worker) keeps its band, so only a wider band allocates
+    static thread_local overlap_band_t band;
 
     int start_row = 1;
     if (d_max < 0) start_row = -d_max + 1;
 
-    band.initialize(start_row, alen + 1);
+    // without start, it is just a score pass (see banded_overlap_start)
+    band.initialize(start_row, alen + 1, blen, d_min, d_max, start != NULL);
+
+    const overlap_drop_t drop(max_error_rate);
+    bool end_viable = false;
 
     // calculate score
-    for (int i = start_row; i < alen + 1; ++i) {
+    for (int i = start_row; band.width > 0 && i < alen + 1; ++i) {
 
         // calculate band (lo inclusive, hi inclusive)
         int lo = std::max(d_min + i, 1);
@@ -565,7 +610,21 @@ int banded_overlap(const char* a, int alen, const char* b, int blen, int d_min,
         // if both diagonals are positive, we don't need full height of matrix
         if (lo > blen) break;
 
-        band.update_band(lo, hi, i, a, b);
+        if (band.track_start)   band.update_band(lo, hi, i, a, b);
+        else                    band.update_band_score(lo, hi, i, a, b);
+
+        if (!drop.enabled) continue;
+
+        int klo = lo - i - band.d_min;
+        int khi = hi - i - band.d_min;
+        if (hi == blen && !end_viable) end_viable = drop.viable(band.middle[khi], i, hi, alen, blen);
+
+        if (i % overlap_drop_t::CHECK_ROWS == 0 && lo > 1 && !end_viable &&
+                !drop.row_viable(&band.middle[0], klo, khi, i, band.d_min, alen, blen)) {
+            if (start != NULL)  set_pair(start, -1, -1);
+            if (end != NULL)    set_pair(end, -1, -1);
+            return REJECTED_EARLY;
+        }
     }
 
     if (start != NULL)  *start = band.best_start;
@@ -575,3 +634,381 @@ int banded_overlap(const char* a, int alen, const char* b, int blen, int d_min,
 
     return best_score;
 }
+
+int banded_overlap_start(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
+        int score, const std::pair<int, int>& end, std::pair<int, int>* start) {
+
+    // values are suffix scores, so they can be far below zero; keep the sentinel away from INT_MIN
+    const int neg_inf = INT_MIN / 2;
+
+    int start_row = 1;
+    if (d_max < 0) start_row = -d_max + 1;
+
+    // diagonals outside of the matrix are never used
+    d_min = std::max(d_min, -alen);
+    d_max = std::min(d_max, blen);
+
+    int width = std::max(d_max - d_min + 1, 0);
+
+    // best scores from a cell to the end of the overlap, for the row below (next) and the current row;
+    // diagonal d is stored at d - d_min + 1 so the diagonal left of the band is always NEG_INF.
+    // Like the band in banded_overlap, they are kept per thread.
+    static thread_local std::vector<int> next_middle, next_gapa, curr_middle, curr_gapa;
+    next_middle.assign(width + 2, neg_inf);
+    next_gapa.assign(width + 2, neg_inf);
+    curr_middle.assign(width + 2, neg_inf);
+    curr_gapa.assign(width + 2, neg_inf);
+
+    // reverse pass: finds the first row an overlap with the score can go through
+    int first_row = start_row;
+    int next_hi = -1;
+    for (int i = end.first; i >= start_row; --i) {
+
+        // same band as in the forward pass, cut at the end of the overlap
+        int lo = std::max(d_min + i, 1);
+        int hi = std::min(d_max + i, blen);
+        int last = std::min(hi, end.second);
+        int row_bound = neg_inf;
+
+        std::fill(curr_middle.begin(), curr_middle.end(), neg_inf);
+        std::fill(curr_gapa.begin(), curr_gapa.end(), neg_inf);
+
+        int gapb_right = neg_inf;
+        for (int j = last; j >= lo; --j) {
+
+            int k = j - i - d_min + 1;
+            int middle = i == end.first && j == end.second ? 0 : neg_inf;
+            int gapa = neg_inf;
+
+            if (i < end.first) {
+                if (j < blen) middle = std::max(middle, next_middle[k] + match_score[(int) a[i]][(int) b[j]]);
+
+                // gapa is not allowed in the last column of the band
+                if (j < next_hi) {
+                    middle = std::max(middle, next_gapa[k - 1] + INDEL_SCORE + GAP_SCORE);
+                    gapa = next_gapa[k - 1] + INDEL_SCORE;
+                }
+            }
+
+            middle = std::max(middle, gapb_right + INDEL_SCORE + GAP_SCORE);
+
+            curr_middle[k] = middle;
+            curr_gapa[k] = std::max(middle, gapa);
+            gapb_right = std::max(middle, gapb_right + INDEL_SCORE);
+
+            // an overlap reaching (i, j) from the border has at most min(i, j) matches
+            row_bound = std::max(row_bound, curr_gapa[k] + std::min(i, j) * MATCH_SCORE);
+        }
+
+        // nothing above this row can still make it to the score of the overlap
+        if (row_bound < score) {
+            first_row = i + 1;
+            break;
+        }
+
+        swap(next_middle, curr_middle);
+        swap(next_gapa, curr_gapa);
+        next_hi = hi;
+    }
+
+    // Forward pass over the rows from first_row on, following the start like banded_overlap does.
+    // A cell it could prefer on a tie is on an overlap with the score too, so it is in these rows
+    // and gets the same score as in the whole band; the start is the one banded_overlap gives.
+    // Cells right of the end never lead to it.
+    static thread_local overlap_band_t band;
+    band.initialize(first_row, end.first + 1, blen, d_min, d_max, true);
+
+    for (int i = first_row; band.width > 0 && i <= end.first; ++i) {
+        int lo = std::max(d_min + i, 1);
+        int hi = std::min(std::min(d_max + i, blen), end.second);
+        band.update_band(lo, hi, i, a, b);
+    }
+
+    int k = end.second - end.first - band.d_min;
+    *start = border_cell(band.middle_start[k]);
+
+    return band.middle[k];
+}
+
+// score of the global alignment of a and b, using only diagonals (col - row) in [d_min, d_max]
+int banded_global(const char* a, int alen, const char* b, int blen, int d_min, int d_max) {
+
+    if (alen == 0 && blen == 0) return 0;
+    if (alen == 0 || blen == 0) return (alen + blen) * INDEL_SCORE + GAP_SCORE;
+
+    const int neg_inf = INT_MIN / 2;
+    int width = d_max - d_min + 1;
+
+    // diagonal d is stored at d - d_min + 1, one NEG_INF diagonal on both sides of the band;
+    // rows are updated in place like in overlap_band_t
+    static thread_local std::vector<int> middle, gapa;
+    middle.assign(width + 2, neg_inf);
+    gapa.assign(width + 2, neg_inf);
+
+    for (int d = std::max(d_min, 0); d <= std::min(d_max, blen); ++d) {
+        middle[d - d_min + 1] = d == 0 ? 0 : d * INDEL_SCORE + GAP_SCORE;
+    }
+
+    for (int i = 1; i < alen + 1; ++i) {
+        int dlo = std::max(d_min, -i);
+        int dhi = std::min(d_max, blen - i);
+        if (dlo > dhi) return neg_inf;
+
+        int ca = a[i - 1];
+        int gapb = neg_inf, left = neg_inf;
+
+        for (int d = dlo; d <= dhi; ++d) {
+            int k = d - d_min + 1;
+            int j = i + d;
+
+            gapb = std::max(gapb + INDEL_SCORE, left + INDEL_SCORE + GAP_SCORE);
+            int gapa_score = std::max(gapa[k + 1] + INDEL_SCORE, middle[k + 1] + INDEL_SCORE + GAP_SCORE);
+
+            left = std::max(gapa_score, gapb);
+            if (j > 0) left = std::max(left, middle[k] + match_score[ca][(int) b[j - 1]]);
+
+            gapa[k] = gapa_score;
+            middle[k] = left;
+        }
+    }
+
+    if (blen - alen < d_min || blen - alen > d_max) return neg_inf;
+    return middle[blen - alen - d_min + 1];
+}
+
+// run of matched bases made of overlapping anchors on one diagonal
+struct anchored_segment_t {
+    int i;
+    int j;
+    int len;
+};
+
+int anchored_overlap(const char* a, int alen, const char* b, int blen,
+        const std::pair<int, int>* anchors, int anchors_len, int anchor_len, int radius,
+        std::pair<int, int>* start, std::pair<int, int>* end) {
+
+    static thread_local std::vector<anchored_segment_t> segments;
+    static thread_local std::vector<char> ra, rb;
+    segments.clear();
+
+    // anchors on one diagonal merge into a segment, the ones overlapping a segment on
+    // another diagonal are cut so that the path always moves forward in both strings
+    for (int n = 0; n < anchors_len; ++n) {
+        int ai = anchors[n].first, bj = anchors[n].second;
+        if (ai < 0 || bj < 0 || ai + anchor_len > alen || bj + anchor_len > blen) continue;
+
+        if (segments.empty()) {
+            segments.push_back({ ai, bj, anchor_len });
+            continue;
+        }
+
+        anchored_segment_t& last = segments.back();
+        int skip = std::max(last.i + last.len - ai, last.j + last.len - bj);
+
+        if (ai - last.i == bj - last.j && ai <= last.i + last.len) {
+            last.len = std::max(last.len, ai + anchor_len - last.i);
+        } else if (skip < anchor_len) {
+            skip = std::max(skip, 0);
+            segments.push_back({ ai + skip, bj + skip, anchor_len - skip });
+        }
+    }
+
+    if (segments.empty()) {
+        set_pair(start, -1, -1);
+        set_pair(end, -1, -1);
+        return NEG_INF;
+    }
+
+    // head: from the top or the left border to the first segment
+    const anchored_segment_t& first = segments.front();
+    int score = 0;
+    if (first.i == 0 || first.j == 0) {
+        set_pair(start, first.i, first.j);
+    } else {
+        int d = first.j - first.i;
+        score += banded_overlap_start(a, first.i, b, first.j, d - radius, d + radius,
+                NEG_INF, std::make_pair(first.i, first.j), start);
+    }
+
+    for (int n = 0, len = segments.size(); n < len; ++n) {
+        const anchored_segment_t& s = segments[n];
+
+        // anchors come from hashes, so matches are still checked
+        for (int k = 0; k < s.len; ++k) {
+            score += match_score[(int) a[s.i + k]][(int) b[s.j + k]];
+        }
+
+        if (n + 1 < len) {
+            const anchored_segment_t& next = segments[n + 1];
+            int gi = next.i - s.i - s.len, gj = next.j - s.j - s.len;
+            score += banded_global(a + s.i + s.len, gi, b + s.j + s.len, gj,
+                    std::min(0, gj - gi) - radius, std::max(0, gj - gi) + radius);
+        }
+    }
+
+    // tail: from the last segment to the bottom or the right border, aligned in reverse
+    // so that it starts on the border and banded_overlap_start can do it
+    const anchored_segment_t& last = segments.back();
+    int ei = last.i + last.len, ej = last.j + last.len;
+    int la = alen - ei, lb = blen - ej;
+    if (la == 0 || lb == 0) {
+        set_pair(end, ei, ej);
+    } else {
+        ra.assign(a + ei, a + alen);
+        rb.assign(b + ej, b + blen);
+        std::reverse(ra.begin(), ra.end());
+        std::reverse(rb.begin(), rb.end());
+
+        std::pair<int, int> reversed_start;
+        score += banded_overlap_start(&ra[0], la, &rb[0], lb, lb - la - radius, lb - la + radius,
+                NEG_INF, std::make_pair(la, lb), &reversed_start);
+        set_pair(end, alen - reversed_start.first, blen - reversed_start.second);
+    }
+
+    return score;
+}
+
+// one step of Myers' algorithm on a 64-row block, returns the horizontal delta of row hbit
+inline int edit_distance_block(uint64_t& vp, uint64_t& vn, uint64_t eq, int hin, int hbit) {
+
+    uint64_t xv = eq | vn;
+    if (hin < 0) eq |= 1;
+
+    uint64_t xh = (((eq & vp) + vp) ^ vp) | eq;
+    uint64_t ph = vn | ~(xh | vp);
+    uint64_t mh = vp & xh;
+
+    int hout = ((ph >> hbit) & 1) - ((mh >> hbit) & 1);
+
+    ph <<= 1;
+    mh <<= 1;
+    if (hin < 0)        mh |= 1;
+    else if (hin > 0)   ph |= 1;
+
+    vp = mh | ~(xv | ph);
+    vn = ph & xv;
+
+    return hout;
+}
+
+void banded_edit_distance(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
+        int* last_row, int* last_col) {
+
+    const int W = 64;
+    const uint64_t ONES = ~(uint64_t) 0;
+
+    for (int k = 0; k < d_max - d_min + 1; ++k) {
+        last_row[k] = last_col[k] = INT_MAX;
+    }
+
+    // rows (characters of a) go into bits, block q holds rows q * W + 1 .. q * W + W;
+    // every block keeps the distance in its bottom row, the last block ends with row alen
+    int blocks = (alen + W - 1) / W;
+    static thread_local std::vector<uint64_t> vp, vn, peq;
+    static thread_local std::vector<int> bottom;
+    vp.resize(blocks);
+    vn.resize(blocks);
+    peq.resize(4 * blocks);
+    bottom.resize(blocks);
+
+    int qlo = 0, qhi = -1;
+    for (int j = 1; j <= blen; ++j) {
+
+        // rows of the band in this column
+        int lo = std::max(j - d_max, 1);
+        int hi = std::min(j - d_min, alen);
+
+        if (lo > alen) break;
+        if (lo > hi) continue;
+
+        int new_qlo = (lo - 1) / W;
+        int new_qhi = (hi - 1) / W;
+
+        // blocks entering the band; column j - 1 above them is either the left border
+        // (distance 0) or outside of the band, where the distance grows down the column
+        for (int q = std::max(qhi + 1, new_qlo); q <= new_qhi; ++q) {
+
+            int q_bottom = std::min(q * W + W, alen);
+            if (j == 1) {
+                vp[q] = 0;
+                bottom[q] = 0;
+            } else {
+                vp[q] = ONES;
+                bottom[q] = q - 1 >= qlo && q - 1 <= qhi ? bottom[q - 1] + q_bottom - q * W : q_bottom;
+            }
+            vn[q] = 0;
+
+            uint64_t* q_peq = &peq[4 * q];
+            q_peq[0] = q_peq[1] = q_peq[2] = q_peq[3] = 0;
+            for (int i = q * W + 1; i <= q_bottom; ++i) {
+                q_peq[(int) a[i - 1]] |= (uint64_t) 1 << (i - 1 - q * W);
+            }
+        }
+
+        qlo = new_qlo;
+        qhi = new_qhi;
+
+        // top row is free, a block below the band's top only sees growing distances
+        int hin = qlo == 0 ? 0 : 1;
+        int c = b[j - 1];
+
+        for (int q = qlo; q <= qhi; ++q) {
+            uint64_t eq = peq[4 * q + c];
+            int hbit = std::min(q * W + W, alen) - 1 - q * W;
+
+            hin = edit_distance_block(vp[q], vn[q], eq, hin, hbit);
+            bottom[q] += hin;
+        }
+
+        if (hi == alen) {
+            last_row[j - alen - d_min] = bottom[qhi];
+        }
+
+        if (j == blen) {
+            // walks up the column from the bottom of every block
+            for (int q = qhi; q >= qlo; --q) {
+                int dist = bottom[q];
+                for (int i = std::min(q * W + W, alen); i > q * W; --i) {
+                    if (i >= lo && i <= hi) last_col[blen - i - d_min] = dist;
+
+                    uint64_t bit = (uint64_t) 1 << (i - 1 - q * W);
+                    if (vp[q] & bit)        --dist;
+                    else if (vn[q] & bit)   ++dist;
+                }
+            }
+        }
+    }
+}
+
+simd_level_t simd_level() {
+
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))     return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse4.1"))   return SIMD_SSE41;
+#endif
+    return SIMD_NONE;
+}
+
+const char* simd_level_name(simd_level_t level) {
+
+    if (level == SIMD_AVX2)     return "avx2";
+    if (level == SIMD_SSE41)    return "sse4.1";
+    return "scalar";
+}
+
+int banded_overlap_simd(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
+        std::pair<int, int>* start, std::pair<int, int>* end, double max_error_rate) {
+
+    static const simd_level_t level = simd_level();
+
+    // 16-bit lanes are exact only up to this length, see banded_simd.cpp
+    if (alen + blen > SIMD_MAX_OVERLAP_LEN || d_min > d_max) {
+        return banded_overlap(a, alen, b, blen, d_min, d_max, start, end, max_error_rate);
+    }
+
+    if (level == SIMD_AVX2)     return banded_overlap_avx2(a, alen, b, blen, d_min, d_max, start, end, max_error_rate);
+    if (level == SIMD_SSE41)    return banded_overlap_sse41(a, alen, b, blen, d_min, d_max, start, end, max_error_rate);
+
+    return banded_overlap(a, alen, b, blen, d_min, d_max, start, end, max_error_rate);
+}
@@ -3,8 +3,18 @@
 #define _ALIGN_H
 
 #include <cstdlib>
+#include <climits>
 #include <utility>
+#include <vector>
+#include <algorithm>
 
+#define NEG_INF (INT_MIN + 100)
+
+// returned instead of a score when the band was left early, see overlap_drop_t
+#define REJECTED_EARLY (NEG_INF - 1)
+
+// All the aligners take sequences as 2-bit base codes (A 0, C 1, G 2, T 3, see encode_bases),
+// which index match_score directly.
 const int MATCH_SCORE = 1;
 const int MISMATCH_SCORE = -3;
 const int INDEL_SCORE = -3;
@@ -13,29 +23,72 @@ const int GAP_SCORE = -1;
 char** create_char_matrix(int r, int c);
 int** create_int_matrix(int r, int c);
 
+// One row of the band, stored by diagonal (k = col - row - d_min) and updated in
+// place, so it takes O(d_max - d_min) memory however long the strings are.
+// Buffers only grow, so a band that is reused between calls (banded_overlap keeps
+// one per thread) stops allocating once it has seen the widest band.
 struct overlap_band_t {
 
+    int d_min;
     int width;
     int height;
+    int blen;
+    bool track_start;
 
-    int *gapa_curr;
-    int *middle_prev;
-    int *middle_curr;
-    int *gapb_curr;
+    std::vector<int> gapa;
+    std::vector<int> middle;
 
-    std::pair<int, int>* gapa_start;
-    std::pair<int, int>* middle_prev_start;
-    std::pair<int, int>* middle_curr_start;
-    std::pair<int, int>* gapb_start;
+    // diagonal (col - row) of the border cell where the overlap starts
+    std::vector<int> gapa_start;
+    std::vector<int> middle_start;
 
     int best_score;
     std::pair<int, int> best_start;
     std::pair<int, int> best_end;
 
-    overlap_band_t(int height, int width);
-    ~overlap_band_t();
-    void initialize(int start_row, int height);
+    overlap_band_t();
+    void initialize(int start_row, int height, int blen, int d_min, int d_max, bool track_start = true);
     void update_band(int lo, int hi, int row, const char *a, const char *b);
+    void update_band_score(int lo, int hi, int row, const char *a, const char *b);
+};
+
+// Early exit of banded overlap, like an X-drop whose drop comes from the error rate limit.
+// An overlap of length len passes when len - score < c * len, c = -(INDEL_SCORE + GAP_SCORE +
+// MISMATCH_SCORE) * max_error_rate, so it passes if (1 - c) * len - score ends up below 0 (plus
+// the rounding of approximate_errors). Along a path that only grows, by c per match at most,
+// and a cell with score S that is x rows (or columns) away from the border the path starts on
+// has it at least -c * x + gap_cost * (x - S), whatever gaps the path took. A band is left when
+// that, less c for every base the overlap can still be extended by, is too high in every cell,
+// no end could pass so far and no overlap can start further down the left border.
+struct overlap_drop_t {
+
+    bool enabled;
+    double rate;
+    double gap_cost;
+
+    overlap_drop_t(double max_error_rate);
+
+    // whether an overlap through the cell (row, col) with this score could still pass
+    inline bool viable(int score, int row, int col, int alen, int blen) const {
+        double rest = rate * std::min(alen - row, blen - col);
+        double from_top = -rate * row + gap_cost * std::max((double) row - score, 0.);
+        double from_left = -rate * col + gap_cost * std::max((double) col - score, 0.);
+        return std::min(from_top, from_left) - rest < MARGIN;
+    }
+
+    // whether any cell of the row, stored by diagonal from d_min, could still pass
+    template <typename T>
+    bool row_viable(const T* middle, int klo, int khi, int row, int d_min, int alen, int blen) const {
+        for (int k = klo; k <= khi; ++k) {
+            if (viable(middle[k], row, row + d_min + k, alen, blen)) return true;
+        }
+        return false;
+    }
+
+    // rows between two checks, the check is as expensive as a row of the band
+    static const int CHECK_ROWS = 16;
+    // approximate_errors rounds down, so an overlap can pass with a bit more than c * len
+    static constexpr double MARGIN = 1 - (INDEL_SCORE + GAP_SCORE + MISMATCH_SCORE);
 };
 
 int local_alignment(const char* a, int alen, const char* b, int blen, std::pair<int, int>* start, std::pair<int, int>* end);
@@ -46,7 +99,59 @@ int overlap_alignment(const char* a, int alen, const char* b, int blen,
 int banded_overlap2(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
         std::pair<int, int>* start, std::pair<int, int>* end, int** score = NULL, char** backtrack = NULL);
 
+// With max_error_rate below 1, returns REJECTED_EARLY as soon as no overlap in the band
+// can have a lower error rate (see overlap_drop_t); start and end are then (-1, -1).
 int banded_overlap(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
-        std::pair<int, int>* start = NULL, std::pair<int, int>* end = NULL);
+        std::pair<int, int>* start = NULL, std::pair<int, int>* end = NULL, double max_error_rate = 1);
+
+// Second phase of the two-phase banded overlap. When banded_overlap gets no start, it
+// does just a score pass; this one recovers the start. A reverse banded pass anchored at
+// the end finds the first row an overlap with the score can go through, and a forward
+// pass from that row to the end gives the start banded_overlap would, ties included.
+// Returns the score of the best overlap ending in end.
+int banded_overlap_start(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
+        int score, const std::pair<int, int>& end, std::pair<int, int>* start);
+
+// Overlap that goes through the given anchors, exact matches of anchor_len bases
+// starting at (a, b) positions and sorted by position in a. Only the gaps between
+// anchors, and before the first and after the last one, are aligned, each with a
+// small banded DP (radius diagonals around the anchors), so the work grows with the
+// unanchored part of the overlap instead of its length. The score is a lower bound
+// of banded_overlap over a band containing the anchors.
+int anchored_overlap(const char* a, int alen, const char* b, int blen,
+        const std::pair<int, int>* anchors, int anchors_len, int anchor_len, int radius,
+        std::pair<int, int>* start, std::pair<int, int>* end);
+
+// Bit-parallel (Myers/Hyyro) edit distance of overlaps inside the band, with free
+// starts on the top and the left border like in banded_overlap. Cells just outside
+// of the band may be used too, so the distances are lower bounds for the band.
+// For every diagonal d in [d_min, d_max], last_row[d - d_min] gets the distance of
+// an overlap ending in (alen, alen + d) and last_col[d - d_min] of one ending in
+// (blen - d, blen); ends outside of the matrix get INT_MAX.
+void banded_edit_distance(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
+        int* last_row, int* last_col);
+
+// Vectorized banded_overlap (16-bit saturated lanes). Results are identical to
+// banded_overlap; pairs longer than SIMD_MAX_OVERLAP_LEN in total, or CPUs
+// without SSE4.1, use the scalar implementation.
+const int SIMD_MAX_OVERLAP_LEN = 16000;
+
+enum simd_level_t {
+    SIMD_NONE,
+    SIMD_SSE41,
+    SIMD_AVX2
+};
+
+simd_level_t simd_level();
+const char* simd_level_name(simd_level_t level);
+
+int banded_overlap_sse41(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
+        std::pair<int, int>* start = NULL, std::pair<int, int>* end = NULL, double max_error_rate = 1);
+
+int banded_overlap_avx2(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
+        std::pair<int, int>* start = NULL, std::pair<int, int>* end = NULL, double max_error_rate = 1);
+
+int banded_overlap_simd(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
+        std::pair<int, int>* start = NULL, std::pair<int, int>* end = NULL, double max_error_rate = 1);
 
 #endif
@@ -0,0 +1,46 @@
+// AVX2 build of the vectorized banded overlap (16 x 16-bit lanes).
+#include "./align.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+struct avx2_ops {
+    typedef __m256i vec;
+    static const int lanes = 16;
+
+    static inline vec set1(int16_t x)               { return _mm256_set1_epi16(x); }
+    static inline vec load(const int16_t* p)        { return _mm256_loadu_si256((const __m256i*) p); }
+    static inline void store(int16_t* p, vec v)     { _mm256_storeu_si256((__m256i*) p, v); }
+    static inline vec load_bases(const char* p)     { return _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*) p)); }
+    static inline vec adds(vec a, vec b)            { return _mm256_adds_epi16(a, b); }
+    static inline vec cmpgt(vec a, vec b)           { return _mm256_cmpgt_epi16(a, b); }
+    static inline vec cmpeq(vec a, vec b)           { return _mm256_cmpeq_epi16(a, b); }
+    static inline vec and_(vec a, vec b)            { return _mm256_and_si256(a, b); }
+    // mask ? b : a
+    static inline vec blend(vec a, vec b, vec mask) { return _mm256_blendv_epi8(a, b, mask); }
+    static inline int16_t last(vec v)               { return _mm256_extract_epi16(v, 15); }
+
+    // lane l gets v[l - S], the first S lanes are taken from the top of fill;
+    // alignr works per 128-bit half, so the halves are stitched first
+    template <int S>
+    static inline vec shift_up(vec v, vec fill) {
+        vec stitched = _mm256_permute2x128_si256(v, fill, 0x03);
+        return _mm256_alignr_epi8(v, stitched, 16 - 2 * S);
+    }
+};
+
+#include "./banded_simd.cpp"
+
+int banded_overlap_avx2(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
+        std::pair<int, int>* start, std::pair<int, int>* end, double max_error_rate) {
+
+    if (start == NULL) return banded_overlap_kernel<avx2_ops, false>(a, alen, b, blen, d_min, d_max, start, end, max_error_rate);
+    return banded_overlap_kernel<avx2_ops, true>(a, alen, b, blen, d_min, d_max, start, end, max_error_rate);
+}
+#else
+int banded_overlap_avx2(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
+        std::pair<int, int>* start, std::pair<int, int>* end, double max_error_rate) {
+
+    return banded_overlap(a, alen, b, blen, d_min, d_max, start, end, max_error_rate);
+}
+#endif
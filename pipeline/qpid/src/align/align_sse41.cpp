@@ -0,0 +1,42 @@
+// SSE4.1 build of the vectorized banded overlap (8 x 16-bit lanes).
+#include "./align.h"
+
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+
+struct sse41_ops {
+    typedef __m128i vec;
+    static const int lanes = 8;
+
+    static inline vec set1(int16_t x)               { return _mm_set1_epi16(x); }
+    static inline vec load(const int16_t* p)        { return _mm_loadu_si128((const __m128i*) p); }
+    static inline void store(int16_t* p, vec v)     { _mm_storeu_si128((__m128i*) p, v); }
+    static inline vec load_bases(const char* p)     { return _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i*) p)); }
+    static inline vec adds(vec a, vec b)            { return _mm_adds_epi16(a, b); }
+    static inline vec cmpgt(vec a, vec b)           { return _mm_cmpgt_epi16(a, b); }
+    static inline vec cmpeq(vec a, vec b)           { return _mm_cmpeq_epi16(a, b); }
+    static inline vec and_(vec a, vec b)            { return _mm_and_si128(a, b); }
+    // mask ? b : a
+    static inline vec blend(vec a, vec b, vec mask) { return _mm_blendv_epi8(a, b, mask); }
+    static inline int16_t last(vec v)               { return _mm_extract_epi16(v, 7); }
+
+    // lane l gets v[l - S], the first S lanes are taken from the top of fill
+    template <int S>
+    static inline vec shift_up(vec v, vec fill)     { return _mm_alignr_epi8(v, fill, 16 - 2 * S); }
+};
+
+#include "./banded_simd.cpp"
+
+int banded_overlap_sse41(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
+        std::pair<int, int>* start, std::pair<int, int>* end, double max_error_rate) {
+
+    if (start == NULL) return banded_overlap_kernel<sse41_ops, false>(a, alen, b, blen, d_min, d_max, start, end, max_error_rate);
+    return banded_overlap_kernel<sse41_ops, true>(a, alen, b, blen, d_min, d_max, start, end, max_error_rate);
+}
+#else
+int banded_overlap_sse41(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
+        std::pair<int, int>* start, std::pair<int, int>* end, double max_error_rate) {
+
+    return banded_overlap(a, alen, b, blen, d_min, d_max, start, end, max_error_rate);
+}
+#endif
@@ -0,0 +1,247 @@
+// Vectorized banded_overlap, shared by the SSE4.1 and AVX2 builds.
+//
+// This file is included by align_sse41.cpp and align_avx2.cpp; each of them
+// provides a struct of vector primitives (V) for its instruction set and is
+// compiled with the matching -m flag.
+//
+// The band is stored by diagonal (k = col - row - d_min) instead of by column,
+// so a row of the band is a contiguous run of lanes:
+//   - match/mismatch reads lane k of the previous row,
+//   - gap in b (vertical) reads lane k + 1 of the previous row,
+//   - gap in a (horizontal) is a prefix scan over the lanes of the current row.
+//
+// Every overlap starts on the top or the left border of the matrix, so the
+// start is tracked as the diagonal (col - row) of that border cell, which
+// fits in a 16-bit lane next to the score.
+//
+// Scores use 16-bit saturated arithmetic. banded_overlap_simd only calls
+// the kernel when alen + blen <= SIMD_MAX_OVERLAP_LEN; below that bound real
+// scores never saturate and never get close to the -inf lanes, so the result
+// is identical to banded_overlap, including the tie-breaking, and so is the early
+// exit, which checks the same rows of the same scores.
+#include <cstdint>
+#include <climits>
+#include <vector>
+#include <algorithm>
+
+const int16_t SIMD_NEG_INF = INT16_MIN;
+
+template <typename V, bool track_start, int S, bool done = (S >= V::lanes)>
+struct gap_scan {
+    // g[l] = max(g[l], g[l - S] + S * INDEL_SCORE), the earlier (longer) gap wins ties
+    static inline void run(typename V::vec& g, typename V::vec& gs) {
+        typename V::vec neg = V::set1(SIMD_NEG_INF);
+        typename V::vec sg = V::adds(V::template shift_up<S>(g, neg), V::set1(S * INDEL_SCORE));
+        typename V::vec keep = V::cmpgt(g, sg);
+
+        g = V::blend(sg, g, keep);
+        if (track_start) gs = V::blend(V::template shift_up<S>(gs, gs), gs, keep);
+
+        gap_scan<V, track_start, 2 * S>::run(g, gs);
+    }
+};
+
+template <typename V, bool track_start, int S>
+struct gap_scan<V, track_start, S, true> {
+    static inline void run(typename V::vec&, typename V::vec&) {}
+};
+
+// with track_start == false it is only a score pass, start is left untouched
+template <typename V, bool track_start>
+int banded_overlap_kernel(const char* a, int alen, const char* b, int blen, int d_min, int d_max,
+        std::pair<int, int>* start, std::pair<int, int>* end, double max_error_rate) {
+
+    typedef typename V::vec vec;
+    const int L = V::lanes;
+
+    int start_row = 1;
+    if (d_max < 0) start_row = -d_max + 1;
+
+    int best_score = INT_MIN, best_code = 0;
+    std::pair<int, int> best_end(-1, -1);
+
+    // diagonals outside of the matrix behave exactly like its edges
+    d_min = std::max(d_min, -alen);
+    d_max = std::min(d_max, blen);
+
+    // band is completely out of the matrix
+    if (d_min > d_max || start_row > alen) {
+        if (start != NULL)  *start = best_end;
+        if (end != NULL)    *end = best_end;
+        return NEG_INF;
+    }
+
+    const int W = d_max - d_min + 1;
+    const int size = ((W + L) / L) * L + L;
+    const int16_t init_value = start_row == 1 ? 0 : SIMD_NEG_INF;
+
+    // kept per thread between calls, so the kernel only allocates when the band gets wider
+    static thread_local std::vector<int16_t> middle, middle_start, gapa, gapa_start;
+    static thread_local std::vector<char> b_padded;
+
+    middle.assign(size, init_value);
+    gapa.assign(size, init_value);
+    if (track_start) {
+        middle_start.resize(size);
+        gapa_start.resize(size);
+        for (int k = 0; k < size; ++k) {
+            middle_start[k] = gapa_start[k] = d_min + k;
+        }
+    }
+
+    // b padded so that lanes outside of the matrix can be loaded blindly
+    const int b_first = start_row + d_min - 1;
+    const int b_last = alen + d_min - 1 + size;
+    b_padded.assign(b_last - b_first + 1, 0);
+    for (int j = std::max(b_first, 0); j < std::min(b_last + 1, blen); ++j) {
+        b_padded[j - b_first] = b[j];
+    }
+
+    // lane numbers and the cost of extending a gap over 1..L lanes
+    int16_t lanes[L], steps[L];
+    for (int l = 0; l < L; ++l) {
+        lanes[l] = l;
+        steps[l] = (l + 1) * INDEL_SCORE;
+    }
+
+    const vec neg = V::set1(SIMD_NEG_INF);
+    const vec lane = V::load(lanes);
+    const vec carry_step = V::load(steps);
+    const vec match = V::set1(MATCH_SCORE);
+    const vec mismatch = V::set1(MISMATCH_SCORE);
+    const vec extend = V::set1(INDEL_SCORE);
+    const vec open = V::set1(INDEL_SCORE + GAP_SCORE);
+
+    const overlap_drop_t drop(max_error_rate);
+    bool end_viable = false;
+
+    for (int i = start_row; i < alen + 1; ++i) {
+
+        // calculate band (lo inclusive, hi inclusive)
+        int lo = std::max(d_min + i, 1);
+        int hi = std::min(d_max + i, blen);
+
+        // if both diagonals are positive, we don't need full height of matrix
+        if (lo > blen) break;
+
+        int klo = lo - i - d_min;
+        int khi = hi - i - d_min;
+
+        // allows skipping arbitrary number of characters in first string
+        if (lo == 1) {
+            middle[klo] = 0;
+            if (track_start) middle_start[klo] = -(i - 1);
+        }
+
+        // ensures that gapa won't use any field from last step that wasn't involved in band
+        middle[khi + 1] = SIMD_NEG_INF;
+        gapa[khi + 1] = SIMD_NEG_INF;
+
+        const vec ca = V::set1(a[i - 1]);
+        const char* row_b = &b_padded[i + d_min - 1 - b_first];
+        const vec vlo = V::set1(klo - 1);
+        const vec vhi = V::set1(khi + 1);
+
+        vec t_prev = neg, ts_prev = neg;
+        vec carry = neg, carry_start = neg;
+
+        for (int kb = klo - klo % L; kb <= khi; kb += L) {
+
+            vec m0 = V::load(&middle[kb]);
+            vec m1 = V::load(&middle[kb + 1]);
+            vec ga1 = V::load(&gapa[kb + 1]);
+            vec ms0 = neg, ms1 = neg, gas1 = neg;
+            if (track_start) {
+                ms0 = V::load(&middle_start[kb]);
+                ms1 = V::load(&middle_start[kb + 1]);
+                gas1 = V::load(&gapa_start[kb + 1]);
+            }
+
+            vec idx = V::adds(V::set1(kb), lane);
+            vec valid = V::and_(V::cmpgt(idx, vlo), V::cmpgt(vhi, idx));
+
+            // match or mismatch
+            vec diag = V::adds(m0, V::blend(mismatch, match, V::cmpeq(V::load_bases(row_b + kb), ca)));
+
+            // gap in b
+            vec ext = V::adds(ga1, extend);
+            vec opn = V::adds(m1, open);
+            vec take_open = V::cmpgt(opn, ext);
+            vec ga = V::blend(ext, opn, take_open);
+            vec gas = track_start ? V::blend(gas1, ms1, take_open) : neg;
+
+            vec take_gapa = V::cmpgt(ga, diag);
+            vec t = V::blend(neg, V::blend(diag, ga, take_gapa), valid);
+            vec ts = track_start ? V::blend(ms0, gas, take_gapa) : neg;
+
+            // gap in a
+            vec g = V::adds(V::template shift_up<1>(t, t_prev), open);
+            vec gs = track_start ? V::template shift_up<1>(ts, ts_prev) : neg;
+            gap_scan<V, track_start, 1>::run(g, gs);
+
+            // gap in a that was already open before this block
+            vec from_carry = V::adds(carry, carry_step);
+            vec keep = V::cmpgt(g, from_carry);
+            g = V::blend(from_carry, g, keep);
+
+            vec take_gapb = V::cmpgt(g, t);
+            vec m = V::blend(neg, V::blend(t, g, take_gapb), valid);
+
+            V::store(&middle[kb], m);
+            V::store(&gapa[kb], V::blend(neg, ga, valid));
+
+            t_prev = t;
+            carry = V::set1(V::last(g));
+
+            if (track_start) {
+                gs = V::blend(carry_start, gs, keep);
+                V::store(&middle_start[kb], V::blend(ts, gs, take_gapb));
+                V::store(&gapa_start[kb], gas);
+
+                ts_prev = ts;
+                carry_start = V::set1(V::last(gs));
+            }
+        }
+
+        if (hi == blen && middle[khi] > best_score) {
+            best_score = middle[khi];
+            best_code = track_start ? middle_start[khi] : 0;
+            best_end = std::make_pair(i, hi);
+        }
+
+        if (i == alen) {
+            for (int k = klo; k <= khi; ++k) {
+                if (middle[k] > best_score) {
+                    best_score = middle[k];
+                    best_code = track_start ? middle_start[k] : 0;
+                    best_end = std::make_pair(i, k + i + d_min);
+                }
+            }
+        }
+
+        if (!drop.enabled) continue;
+
+        if (hi == blen && !end_viable) end_viable = drop.viable(middle[khi], i, hi, alen, blen);
+
+        if (i % overlap_drop_t::CHECK_ROWS == 0 && lo > 1 && !end_viable &&
+                !drop.row_viable(&middle[0], klo, khi, i, d_min, alen, blen)) {
+            if (start != NULL)  *start = std::make_pair(-1, -1);
+            if (end != NULL)    *end = std::make_pair(-1, -1);
+            return REJECTED_EARLY;
+        }
+    }
+
+    if (best_end.first == -1) {
+        if (start != NULL)  *start = best_end;
+        if (end != NULL)    *end = best_end;
+        return NEG_INF;
+    }
+
+    if (track_start && start != NULL) {
+        if (best_code >= 0) *start = std::make_pair(0, best_code);
+        else                *start = std::make_pair(-best_code, 0);
+    }
+    if (end != NULL)    *end = best_end;
+
+    return best_score;
+}
@@ -1,8 +1,14 @@
 #include "./align.h"
+#include "../encode/encode.h"
 #include <cstring>
 #include <cassert>
 #include <cstdio>
+#include <cstdlib>
+#include <string>
 #include <utility>
+#include <vector>
+#include <algorithm>
+#include <climits>
 
 template <class T>
 void print_matrix(T** matrix, int r, int c, const char *format = "%3d ") {
@@ -15,13 +21,30 @@ void print_matrix(T** matrix, int r, int c, const char *format = "%3d ") {
     }
 }
 
+// aligners take 2-bit codes, while fixed cases read better in letters
+std::string codes(const char* letters) {
+
+    std::string codes(letters);
+    encode_bases(letters, codes.size(), &codes[0]);
+    return codes;
+}
+
+std::string letters(const std::string& codes) {
+
+    std::string letters(codes);
+    for (int i = 0, len = codes.size(); i < len; ++i) {
+        letters[i] = decode_base(codes[i]);
+    }
+    return letters;
+}
+
 void test1() {
 
     char a[] = "ACGTACGT";
     char b[] = "ACGTACGT";
     std::pair<int, int> start, end;
 
-    int score = banded_overlap(a, strlen(a), b, strlen(b), -10, 10, &start, &end);
+    int score = banded_overlap(codes(a).c_str(), strlen(a), codes(b).c_str(), strlen(b), -10, 10, &start, &end);
 
     printf("%s %s %d, s: %d %d, e: %d %d\n", a, b, score, start.first, start.second, end.first, end.second);
 
@@ -38,7 +61,7 @@ void test2() {
     char b[] = "AAAAACGT";
     std::pair<int, int> start, end;
 
-    int score = banded_overlap(a, strlen(a), b, strlen(b), -10, 10, &start, &end);
+    int score = banded_overlap(codes(a).c_str(), strlen(a), codes(b).c_str(), strlen(b), -10, 10, &start, &end);
 
     printf("%s %s %d, s: %d %d, e: %d %d\n", a, b, score, start.first, start.second, end.first, end.second);
 
@@ -55,7 +78,7 @@ void test3() {
     char b[] = "AAAAACGTAACGTACGT";
     std::pair<int, int> start, end;
 
-    int score = banded_overlap(a, strlen(a), b, strlen(b), -strlen(a), strlen(a), &start, &end);
+    int score = banded_overlap(codes(a).c_str(), strlen(a), codes(b).c_str(), strlen(b), -strlen(a), strlen(a), &start, &end);
 
     printf("%s %s %d, s: %d %d, e: %d %d\n", a, b, score, start.first, start.second, end.first, end.second);
 
@@ -73,7 +96,7 @@ void test4() {
     char b[] = "ACGTACCTT";
     std::pair<int, int> start, end;
 
-    int score = banded_overlap(a, strlen(a), b, strlen(b), -strlen(a), strlen(a), &start, &end);
+    int score = banded_overlap(codes(a).c_str(), strlen(a), codes(b).c_str(), strlen(b), -strlen(a), strlen(a), &start, &end);
 
     printf("%s %s %d, s: %d %d, e: %d %d\n", a, b, score, start.first, start.second, end.first, end.second);
 
@@ -91,7 +114,7 @@ void test5() {
     std::pair<int, int> start, end;
 
     // skip first four characters of second string + allow two inserts in first string
-    int score = banded_overlap(a, strlen(a), b, strlen(b), 4, 6, &start, &end);
+    int score = banded_overlap(codes(a).c_str(), strlen(a), codes(b).c_str(), strlen(b), 4, 6, &start, &end);
 
     printf("%s %s %d, s: %d %d, e: %d %d\n", a, b, score, start.first, start.second, end.first, end.second);
 
@@ -109,7 +132,7 @@ void test6() {
     std::pair<int, int> start, end;
 
     // skip first four characters of first string + allow two inserts in first string
-    int score = banded_overlap(a, strlen(a), b, strlen(b), -6, -4, &start, &end);
+    int score = banded_overlap(codes(a).c_str(), strlen(a), codes(b).c_str(), strlen(b), -6, -4, &start, &end);
 
     printf("%s %s %d, s: %d %d, e: %d %d\n", a, b, score, start.first, start.second, end.first, end.second);
 
@@ -125,8 +148,8 @@ void test7() {
     char a[] = "AGTGTGGCGTATTGGGGGTATGGTACGAAAATTGCTCGGAATATCTACGAGGTCTTTAAAAGTTCGCCGACCTAGTACATCCCAGCCAAAAACCCTGATACAATATATTTCGGGGAGAATACTCA";
     char b[] = "GACCTAGTACATCCCAGCCAAAAACCCTGATACAATATATTTCGGGGAGATTACGCTAGATCAAATAACAAGCTCCCCGCCGCCTGGAATCACAGATCAATAGGCAAGACGACATGAAACCGAAG";
 
-    assert(banded_overlap(a, strlen(a), b, strlen(b), -500, 500)
-            == banded_overlap(b, strlen(b), a, strlen(a), -500, 500));
+    assert(banded_overlap(codes(a).c_str(), strlen(a), codes(b).c_str(), strlen(b), -500, 500)
+            == banded_overlap(codes(b).c_str(), strlen(b), codes(a).c_str(), strlen(a), -500, 500));
 }
 
 void test8() {
@@ -135,9 +158,371 @@ void test8() {
     char b[] = "CCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCCACGTACGTACGTAAACGTACGT";
     std::pair<int, int> start, end;
 
-    int score = banded_overlap(a, strlen(a), b, strlen(b), -500, 500, &start, &end);
+    int score = banded_overlap(codes(a).c_str(), strlen(a), codes(b).c_str(), strlen(b), -500, 500, &start, &end);
+
+    printf("%s %s %d, s: %d %d, e: %d %d\n", a, b, score, start.first, start.second, end.first, end.second);
+}
+
+void test9() {
+
+    char a[] = "ACGTACGTACGTACGTACGTAAAA";
+    char b[] = "AAAAACGTACGTACGTAAACGTACGT";
+    std::pair<int, int> start, end;
+
+    // two-phase: score pass first, then the reverse pass for the start
+    int score = banded_overlap(codes(a).c_str(), strlen(a), codes(b).c_str(), strlen(b), 4, 6, NULL, &end);
+    int reverse_score = banded_overlap_start(codes(a).c_str(), strlen(a), codes(b).c_str(), strlen(b), 4, 6, score, end, &start);
 
     printf("%s %s %d, s: %d %d, e: %d %d\n", a, b, score, start.first, start.second, end.first, end.second);
+
+    assert(score == 20 + 2 * INDEL_SCORE + GAP_SCORE);
+    assert(score == reverse_score);
+    assert(0 == start.first);
+    assert(4 == start.second);
+    assert((int) strlen(a) - 4 == end.first);
+    assert((int) strlen(b) == end.second);
+}
+
+// random 2-bit codes
+std::string random_sequence(int len) {
+
+    std::string s(len, 0);
+    for (int i = 0; i < len; ++i) {
+        s[i] = rand() % 4;
+    }
+    return s;
+}
+
+// copies s with roughly rate * len substitutions, insertions and deletions
+std::string mutate(const std::string& s, double rate) {
+
+    std::string r;
+    for (int i = 0, len = s.size(); i < len; ++i) {
+        double p = rand() / (double) RAND_MAX;
+        if (p < rate / 3) {
+            r += (char) (rand() % 4);
+        } else if (p < 2 * rate / 3) {
+            r += s[i];
+            r += (char) (rand() % 4);
+        } else if (p >= rate) {
+            r += s[i];
+        }
+    }
+    return r;
+}
+
+typedef int (*banded_overlap_fn)(const char*, int, const char*, int, int, int,
+        std::pair<int, int>*, std::pair<int, int>*, double);
+
+void compare_with_scalar(banded_overlap_fn fn, const std::string& a, const std::string& b, int d_min, int d_max) {
+
+    std::pair<int, int> start, end, simd_start, simd_end;
+
+    int score = banded_overlap(a.c_str(), a.size(), b.c_str(), b.size(), d_min, d_max, &start, &end);
+    int simd_score = fn(a.c_str(), a.size(), b.c_str(), b.size(), d_min, d_max, &simd_start, &simd_end, 1);
+
+    if (score != simd_score || start != simd_start || end != simd_end) {
+        printf("%s %s [%d, %d]\n", letters(a).c_str(), letters(b).c_str(), d_min, d_max);
+        printf("scalar %d, s: %d %d, e: %d %d\n", score, start.first, start.second, end.first, end.second);
+        printf("simd   %d, s: %d %d, e: %d %d\n", simd_score, simd_start.first, simd_start.second,
+                simd_end.first, simd_end.second);
+    }
+
+    assert(score == simd_score);
+    assert(start == simd_start);
+    assert(end == simd_end);
+
+    // score pass gives the same end, reverse pass the same score from the border
+    std::pair<int, int> score_end, reverse_start;
+    assert(fn(a.c_str(), a.size(), b.c_str(), b.size(), d_min, d_max, NULL, &score_end, 1) == score);
+    assert(score_end == end);
+
+    if (end.first == -1) return;
+
+    int reverse_score = banded_overlap_start(a.c_str(), a.size(), b.c_str(), b.size(), d_min, d_max,
+            score, end, &reverse_start);
+    assert(reverse_score == score);
+    assert(reverse_start == start);
+}
+
+// error rate of the overlap as Overlap calculates it
+double overlap_error_rate(int score, const std::pair<int, int>& start, const std::pair<int, int>& end) {
+
+    int len = (end.first - start.first + end.second - start.second) / 2;
+    int errors = (score - len) / (INDEL_SCORE + GAP_SCORE + MISMATCH_SCORE);
+    return len > 0 ? (double) errors / len : 1;
+}
+
+// a band is left early only when its best overlap does not pass the error rate; otherwise
+// the score pass is the same as without the limit, and the simd kernel leaves the same bands
+void compare_early_rejection(banded_overlap_fn fn, const std::string& a, const std::string& b,
+        int d_min, int d_max, double max_error_rate, int* rejected) {
+
+    std::pair<int, int> start, end, score_end, simd_end;
+
+    int score = banded_overlap(a.c_str(), a.size(), b.c_str(), b.size(), d_min, d_max, &start, &end);
+    int limited = banded_overlap(a.c_str(), a.size(), b.c_str(), b.size(), d_min, d_max, NULL, &score_end,
+            max_error_rate);
+    int simd_limited = fn(a.c_str(), a.size(), b.c_str(), b.size(), d_min, d_max, NULL, &simd_end, max_error_rate);
+
+    assert(limited == simd_limited);
+    assert(score_end == simd_end);
+
+    if (limited == REJECTED_EARLY) {
+        assert(score_end == std::make_pair(-1, -1));
+        assert(end.first == -1 || overlap_error_rate(score, start, end) >= max_error_rate);
+        ++*rejected;
+    } else {
+        assert(limited == score);
+        assert(score_end == end);
+    }
+}
+
+void test_early_rejection(banded_overlap_fn fn, const char* name) {
+
+    srand(7);
+
+    int rejected = 0, unrelated_rejected = 0;
+    for (int iter = 0; iter < 2000; ++iter) {
+        int len = 50 + rand() % 700;
+        std::string genome = random_sequence(len + rand() % len + 1);
+
+        // overlapping reads, noisy enough for some of them not to pass
+        int shift = rand() % (genome.size() - len + 1);
+        std::string a = mutate(genome.substr(0, len), (rand() % 20) / 100.);
+        std::string b = mutate(genome.substr(shift), (rand() % 20) / 100.);
+        if (a.size() == 0 || b.size() == 0) continue;
+
+        int d = shift + rand() % 7 - 3;
+        int radius = rand() % 20;
+        double max_error_rate = (1 + rand() % 15) / 100.;
+
+        compare_early_rejection(fn, a, b, d - radius, d + radius, max_error_rate, &rejected);
+        compare_early_rejection(fn, b, a, -d - radius, -d + radius, max_error_rate, &rejected);
+
+        // the same band over unrelated reads
+        std::string c = random_sequence(b.size());
+        compare_early_rejection(fn, a, c, d - radius, d + radius, max_error_rate, &unrelated_rejected);
+    }
+
+    // unrelated reads are given up on, at the usual error rates
+    assert(rejected > 0);
+    assert(unrelated_rejected > 1000);
+
+    printf("%s leaves %d + %d bands early\n", name, rejected, unrelated_rejected);
+}
+
+// simd kernels have to give exactly the same score, start and end as banded_overlap
+void test_simd(banded_overlap_fn fn, const char* name) {
+
+    srand(42);
+
+    for (int iter = 0; iter < 3000; ++iter) {
+        int len = 1 + rand() % (iter < 1500 ? 40 : 600);
+        std::string genome = random_sequence(len + rand() % len + 1);
+
+        // two reads from the same genome, shifted for a bit
+        int shift = rand() % (genome.size() - len + 1);
+        std::string a = mutate(genome.substr(0, len), (rand() % 10) / 100.);
+        std::string b = mutate(genome.substr(shift), (rand() % 10) / 100.);
+        if (rand() % 2) swap(a, b);
+        if (a.size() == 0 || b.size() == 0) continue;
+
+        int alen = a.size(), blen = b.size();
+        int d = (shift * (rand() % 2 ? 1 : -1)) + rand() % 7 - 3;
+        int radius = rand() % 4 == 0 ? rand() % 40 : rand() % 6;
+
+        compare_with_scalar(fn, a, b, d - radius, d + radius);
+        compare_with_scalar(fn, a, b, d - radius, d + radius + rand() % 30);
+        compare_with_scalar(fn, a, b, -alen - rand() % 5, blen + rand() % 5);
+        compare_with_scalar(fn, a, b, rand() % (2 * (alen + blen)) - alen - blen, rand() % (blen + 2));
+    }
+
+    // unrelated reads and degenerate bands
+    for (int iter = 0; iter < 1000; ++iter) {
+        std::string a = random_sequence(1 + rand() % 100);
+        std::string b = random_sequence(1 + rand() % 100);
+        int d_min = rand() % 250 - 125;
+
+        compare_with_scalar(fn, a, b, d_min, d_min);
+        compare_with_scalar(fn, a, b, d_min, d_min + rand() % 50);
+    }
+
+    compare_with_scalar(fn, codes("ACGT"), codes("ACGT"), -500, 500);
+
+    // repeats and low complexity reads, where many overlaps have the best score and the start
+    // depends on how ties are broken
+    const char* units[] = { "A", "AC", "ACG", "AACT", "ACGTT" };
+    for (int iter = 0; iter < 2000; ++iter) {
+        std::string unit = codes(units[rand() % 5]);
+        std::string repeat;
+        while (repeat.size() < 300) repeat += unit;
+
+        std::string a = mutate(repeat.substr(rand() % 10, 20 + rand() % 250), (rand() % 6) / 100.);
+        std::string b = mutate(repeat.substr(rand() % 10, 20 + rand() % 250), (rand() % 6) / 100.);
+        if (a.size() == 0 || b.size() == 0) continue;
+
+        int alen = a.size(), blen = b.size();
+        int d_min = rand() % (alen + blen) - alen;
+
+        compare_with_scalar(fn, a, b, d_min, d_min + rand() % 30);
+        compare_with_scalar(fn, a, b, -alen, blen);
+    }
+
+    printf("%s matches banded_overlap\n", name);
+}
+
+// edit distance of overlaps ending in every cell, only through cells inside [d_min, d_max]
+std::vector<std::vector<int>> overlap_edit_distances(const std::string& a, const std::string& b, int d_min, int d_max) {
+
+    int alen = a.size(), blen = b.size();
+    const int inf = INT_MAX / 2;
+    std::vector<std::vector<int>> d(alen + 1, std::vector<int>(blen + 1, inf));
+
+    for (int i = 0; i <= alen; ++i) {
+        for (int j = 0; j <= blen; ++j) {
+            if (j - i < d_min || j - i > d_max) continue;
+            if (i == 0 || j == 0) {
+                d[i][j] = 0;
+                continue;
+            }
+            d[i][j] = std::min(d[i - 1][j - 1] + (a[i - 1] != b[j - 1]), std::min(d[i - 1][j], d[i][j - 1]) + 1);
+        }
+    }
+    return d;
+}
+
+void compare_edit_distance(const std::string& a, const std::string& b, int d_min, int d_max) {
+
+    int alen = a.size(), blen = b.size(), width = d_max - d_min + 1;
+    std::vector<int> last_row(width), last_col(width);
+
+    banded_edit_distance(a.c_str(), alen, b.c_str(), blen, d_min, d_max, &last_row[0], &last_col[0]);
+
+    // never above the distance inside the band, never below the one without it
+    std::vector<std::vector<int>> band = overlap_edit_distances(a, b, d_min, d_max);
+    std::vector<std::vector<int>> full = overlap_edit_distances(a, b, -alen, blen);
+    bool whole_matrix = d_min <= -alen && d_max >= blen;
+
+    for (int d = d_min; d <= d_max; ++d) {
+        int j = alen + d, i = blen - d;
+
+        if (j >= 1 && j <= blen) {
+            int dist = last_row[d - d_min];
+            assert(dist <= band[alen][j] && dist >= full[alen][j]);
+            if (whole_matrix) assert(dist == full[alen][j]);
+        } else {
+            assert(last_row[d - d_min] == INT_MAX);
+        }
+
+        if (i >= 1 && i <= alen) {
+            int dist = last_col[d - d_min];
+            assert(dist <= band[i][blen] && dist >= full[i][blen]);
+            if (whole_matrix) assert(dist == full[i][blen]);
+        } else {
+            assert(last_col[d - d_min] == INT_MAX);
+        }
+    }
+}
+
+void test_edit_distance() {
+
+    srand(7);
+
+    for (int iter = 0; iter < 1000; ++iter) {
+        int len = 1 + rand() % (iter < 500 ? 40 : 300);
+        std::string genome = random_sequence(2 * len);
+
+        int shift = rand() % len;
+        std::string a = mutate(genome.substr(0, len), (rand() % 20) / 100.);
+        std::string b = mutate(genome.substr(shift), (rand() % 20) / 100.);
+        if (rand() % 2) swap(a, b);
+        if (a.size() == 0 || b.size() == 0) continue;
+
+        int alen = a.size(), blen = b.size();
+        int d = (shift * (rand() % 2 ? 1 : -1)) + rand() % 7 - 3;
+        int radius = rand() % 4 == 0 ? rand() % 100 : rand() % 6;
+
+        compare_edit_distance(a, b, d - radius, d + radius);
+        compare_edit_distance(a, b, -alen - rand() % 5, blen + rand() % 5);
+        compare_edit_distance(a, b, -rand() % (alen + 1), rand() % (blen + 1));
+    }
+
+    printf("banded_edit_distance is a lower bound\n");
+}
+
+// exact matches of k bases every step bases of a, searched in b around the expected diagonal
+std::vector<std::pair<int, int>> find_anchors(const std::string& a, const std::string& b, int d, int k, int step) {
+
+    std::vector<std::pair<int, int>> anchors;
+    int last_j = -1;
+    for (int i = 0; i + k <= (int) a.size(); i += step) {
+        for (int j = std::max(i + d - 10, last_j + 1); j <= i + d + 10 && j + k <= (int) b.size(); ++j) {
+            if (a.compare(i, k, b, j, k) == 0) {
+                anchors.push_back(std::make_pair(i, j));
+                last_j = j;
+                break;
+            }
+        }
+    }
+    return anchors;
+}
+
+void test_anchored_overlap() {
+
+    srand(11);
+
+    for (int iter = 0; iter < 500; ++iter) {
+        int len = 100 + rand() % 900;
+        std::string genome = random_sequence(2 * len);
+
+        int shift = rand() % (len / 2);
+        std::string a = genome.substr(0, len);
+        std::string b = mutate(genome.substr(shift, len), (rand() % 6) / 100.);
+        if (rand() % 2) swap(a, b), shift = -shift;
+
+        int alen = a.size(), blen = b.size();
+        int d = -shift, radius = 10;
+        std::vector<std::pair<int, int>> anchors = find_anchors(a, b, d, 12, 7);
+        if (anchors.empty()) continue;
+
+        std::pair<int, int> start, end;
+        int score = anchored_overlap(a.c_str(), alen, b.c_str(), blen, &anchors[0], anchors.size(), 12, radius,
+                &start, &end);
+
+        // the anchored path is one of the overlaps banded_overlap looks at
+        int d_min = d - radius, d_max = d + radius;
+        for (int n = 0, len = anchors.size(); n < len; ++n) {
+            d_min = std::min(d_min, anchors[n].second - anchors[n].first - radius);
+            d_max = std::max(d_max, anchors[n].second - anchors[n].first + radius);
+        }
+        std::pair<int, int> full_start, full_end;
+        int full_score = banded_overlap(a.c_str(), alen, b.c_str(), blen, d_min, d_max, &full_start, &full_end);
+
+        assert(score <= full_score);
+        assert(start.first == 0 || start.second == 0);
+        assert(end.first == alen || end.second == blen);
+
+    }
+
+    // substitutions only, between anchors and in the unanchored head and tail
+    std::string genome = random_sequence(600);
+    std::string a = genome.substr(0, 400), b = genome.substr(100);
+    int substitutions = 0;
+    for (int j = 5; j < 300; j += 37, ++substitutions) {
+        b[j] = (b[j] + 1) % 4;
+    }
+    std::vector<std::pair<int, int>> anchors = find_anchors(a.substr(0, 350), b, -100, 12, 30);
+
+    std::pair<int, int> start, end;
+    int score = anchored_overlap(a.c_str(), a.size(), b.c_str(), b.size(), &anchors[0], anchors.size(), 12, 5,
+            &start, &end);
+    assert(score == 300 * MATCH_SCORE + substitutions * (MISMATCH_SCORE - MATCH_SCORE));
+    assert(score == banded_overlap(a.c_str(), a.size(), b.c_str(), b.size(), -105, -95));
+    assert(start.first == 100 && start.second == 0);
+    assert(end.first == 400 && end.second == 300);
+
+    printf("anchored_overlap is a lower bound of banded_overlap\n");
 }
 
 int main() {
@@ -150,6 +535,20 @@ int main() {
     test6();
     test7();
     test8();
+    test9();
+    test_edit_distance();
+    test_anchored_overlap();
+
+    simd_level_t level = simd_level();
+    printf("cpu supports: %s\n", simd_level_name(level));
+
+    if (level >= SIMD_SSE41)    test_simd(banded_overlap_sse41, "sse4.1");
+    if (level >= SIMD_AVX2)     test_simd(banded_overlap_avx2, "avx2");
+    test_simd(banded_overlap_simd, "dispatched");
+
+    test_early_rejection(banded_overlap, "scalar");
+    if (level >= SIMD_SSE41)    test_early_rejection(banded_overlap_sse41, "sse4.1");
+    if (level >= SIMD_AVX2)     test_early_rejection(banded_overlap_avx2, "avx2");
 
     return 0;
 }
@@ -0,0 +1,136 @@
+#include "./chain.h"
+#include <cstdlib>
+#include <algorithm>
+
+// how many previous anchors the DP looks at
+const int MAX_PREDECESSORS = 50;
+
+// least significant digit radix sort by (read, target_pos), a byte per pass
+void sort_anchors(std::vector<anchor_t>& anchors) {
+
+    static thread_local std::vector<anchor_t> sorted;
+
+    int n = anchors.size();
+    sorted.resize(n);
+
+    for (int pass = 0; pass < 8; ++pass) {
+        int shift = 8 * (pass % 4);
+        unsigned int count[257] = { 0 };
+
+        for (int i = 0; i < n; ++i) {
+            unsigned int key = pass < 4 ? anchors[i].target_pos : anchors[i].read;
+            ++count[((key >> shift) & 0xff) + 1];
+        }
+
+        // every anchor has the same byte here, the order stays as it is
+        if (*std::max_element(count, count + 257) == (unsigned int) n) continue;
+
+        for (int d = 0; d < 256; ++d) {
+            count[d + 1] += count[d];
+        }
+        for (int i = 0; i < n; ++i) {
+            unsigned int key = pass < 4 ? anchors[i].target_pos : anchors[i].read;
+            sorted[count[(key >> shift) & 0xff]++] = anchors[i];
+        }
+        anchors.swap(sorted);
+    }
+}
+
+int gap_cost(int gap, int anchor_len) {
+
+    if (gap == 0) return 0;
+
+    int log2_gap = 31 - __builtin_clz(gap);
+    return (int) (0.01 * anchor_len * gap) + log2_gap / 2;
+}
+
+bool by_read_and_score(const chain_t& a, const chain_t& b) {
+    if (a.read != b.read)   return a.read < b.read;
+    if (a.score != b.score) return a.score > b.score;
+    return a.lo_diagonal < b.lo_diagonal;
+}
+
+void chain_anchors(std::vector<anchor_t>& anchors, int anchor_len, int max_gap, int min_score,
+        std::vector<chain_t>& chains, std::vector<anchor_t>* chained) {
+
+    int n = anchors.size();
+    if (n == 0) return;
+
+    sort_anchors(anchors);
+
+    static thread_local std::vector<int> score, prev, order;
+    static thread_local std::vector<bool> used;
+    score.resize(n);
+    prev.resize(n);
+    order.resize(n);
+    used.assign(n, false);
+
+    // score[i] is the best chain ending in anchor i, prev[i] the anchor before it
+    for (int i = 0, first = 0; i < n; ++i) {
+        const anchor_t& a = anchors[i];
+        if (a.read != anchors[first].read) first = i;
+
+        score[i] = anchor_len;
+        prev[i] = -1;
+
+        for (int j = i - 1; j >= std::max(first, i - MAX_PREDECESSORS); --j) {
+            const anchor_t& b = anchors[j];
+
+            int dx = a.target_pos - b.target_pos;
+            int dy = a.query_pos - b.query_pos;
+            if (dx <= 0 || dy <= 0) continue;
+
+            int gap = abs(dy - dx);
+            if (gap > max_gap) continue;
+
+            int chained = score[j] + std::min(std::min(dx, dy), anchor_len) - gap_cost(gap, anchor_len);
+            if (chained > score[i]) {
+                score[i] = chained;
+                prev[i] = j;
+            }
+        }
+    }
+
+    // best chain ends first; a chain stops where it reaches an anchor taken by a better one
+    for (int i = 0; i < n; ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [] (int a, int b) {
+        return score[a] > score[b] || (score[a] == score[b] && a < b);
+    });
+
+    size_t first_chain = chains.size();
+    for (int o = 0; o < n; ++o) {
+        int i = order[o];
+        if (used[i]) continue;
+
+        chain_t chain;
+        chain.read = anchors[i].read;
+        chain.lo_diagonal = chain.hi_diagonal = anchors[i].query_pos - anchors[i].target_pos;
+        chain.anchors = 0;
+
+        int j = i;
+        for (; j >= 0 && !used[j]; j = prev[j]) {
+            int diagonal = anchors[j].query_pos - anchors[j].target_pos;
+            chain.lo_diagonal = std::min(chain.lo_diagonal, diagonal);
+            chain.hi_diagonal = std::max(chain.hi_diagonal, diagonal);
+            chain.anchors++;
+            used[j] = true;
+        }
+        chain.score = j >= 0 ? score[i] - score[j] : score[i];
+
+        if (chain.score >= min_score) {
+            chain.first_anchor = -1;
+            if (chained != NULL) {
+                chain.first_anchor = chained->size();
+                for (int k = i; k != j; k = prev[k]) {
+                    chained->push_back(anchors[k]);
+                }
+                std::reverse(chained->begin() + chain.first_anchor, chained->end());
+            }
+            chains.push_back(chain);
+        }
+    }
+
+    std::sort(chains.begin() + first_chain, chains.end(), by_read_and_score);
+}
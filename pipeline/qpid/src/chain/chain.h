@@ -0,0 +1,34 @@
+#ifndef CHAIN_H
+#define CHAIN_H
+
+#include <cstddef>
+#include <vector>
+
+// minimizer hit shared by the target and a query read
+struct anchor_t {
+    unsigned int read;
+    int target_pos;
+    int query_pos;
+};
+
+// co-linear anchors of one query read, diagonals are query_pos - target_pos
+struct chain_t {
+    unsigned int read;
+    int lo_diagonal;
+    int hi_diagonal;
+    int score;
+    int anchors;
+    // index of the first anchor of the chain in chained, see chain_anchors
+    int first_anchor;
+};
+
+// Sorts anchors by (read, target_pos) and chains them with a co-linear chaining DP,
+// like minimap does: an anchor adds up to anchor_len matching bases, and moving to a
+// diagonal gap away costs 0.01 * anchor_len * gap + log2(gap) / 2. Anchors more than
+// max_gap diagonals apart are never chained. Chains scoring at least min_score are
+// appended to chains, grouped by read with the best chain of a read first.
+// If chained is given, anchors of every kept chain are appended to it in target order.
+void chain_anchors(std::vector<anchor_t>& anchors, int anchor_len, int max_gap, int min_score,
+        std::vector<chain_t>& chains, std::vector<anchor_t>* chained = NULL);
+
+#endif
@@ -0,0 +1,157 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "chain.h"
+
+const int K = 16;
+
+anchor_t anchor(unsigned int read, int target_pos, int query_pos) {
+    anchor_t a;
+    a.read = read;
+    a.target_pos = target_pos;
+    a.query_pos = query_pos;
+    return a;
+}
+
+// hits every 10 bases on one diagonal make a single chain
+void test_single_diagonal() {
+    std::vector<anchor_t> anchors;
+    std::vector<chain_t> chains;
+
+    for (int i = 9; i >= 0; --i) {
+        anchors.push_back(anchor(3, 100 + 10 * i, 40 + 10 * i));
+    }
+    chain_anchors(anchors, K, 500, 0, chains);
+
+    assert(chains.size() == 1);
+    assert(chains[0].read == 3);
+    assert(chains[0].anchors == 10);
+    assert(chains[0].lo_diagonal == -60 && chains[0].hi_diagonal == -60);
+    assert(chains[0].score == K + 9 * 10);
+}
+
+// small indels move the chain over a few diagonals
+void test_drifting_diagonal() {
+    std::vector<anchor_t> anchors;
+    std::vector<chain_t> chains;
+
+    for (int i = 0; i < 20; ++i) {
+        anchors.push_back(anchor(1, 50 * i, 50 * i + i / 4));
+    }
+    chain_anchors(anchors, K, 500, 0, chains);
+
+    assert(chains.size() == 1);
+    assert(chains[0].anchors == 20);
+    assert(chains[0].lo_diagonal == 0 && chains[0].hi_diagonal == 4);
+}
+
+// reads are chained separately and come out grouped, best chain of a read first
+void test_reads_and_repeats() {
+    std::vector<anchor_t> anchors;
+    std::vector<chain_t> chains;
+
+    for (int i = 0; i < 5; ++i) {
+        anchors.push_back(anchor(7, 20 * i, 20 * i + 1000));
+        anchors.push_back(anchor(2, 20 * i, 20 * i + 5));
+        anchors.push_back(anchor(2, 1000 + 20 * i, 20 * i + 5));
+    }
+    anchors.push_back(anchor(2, 2000, 2005));
+    anchors.push_back(anchor(2, 2020, 2025));
+
+    chain_anchors(anchors, K, 500, 0, chains);
+
+    assert(chains.size() == 3);
+    assert(chains[0].read == 2 && chains[0].anchors == 7 && chains[0].hi_diagonal == 5);
+    assert(chains[1].read == 2 && chains[1].anchors == 5 && chains[1].lo_diagonal == -995);
+    assert(chains[2].read == 7 && chains[2].anchors == 5 && chains[2].lo_diagonal == 1000);
+    assert(chains[0].score > chains[1].score);
+}
+
+// lone hits don't make it to min_score
+void test_min_score() {
+    std::vector<anchor_t> anchors;
+    std::vector<chain_t> chains;
+
+    anchors.push_back(anchor(1, 10, 10));
+    anchors.push_back(anchor(2, 10, 300));
+    anchors.push_back(anchor(2, 30, 320));
+    anchors.push_back(anchor(2, 50, 340));
+
+    chain_anchors(anchors, K, 500, 40, chains);
+
+    assert(chains.size() == 1);
+    assert(chains[0].read == 2);
+    assert(chains[0].score == 3 * K);
+}
+
+// anchors of every chain come out in target order, past the ones already there
+void test_chained_anchors() {
+    std::vector<anchor_t> anchors, chained(2);
+    std::vector<chain_t> chains;
+
+    for (int i = 4; i >= 0; --i) {
+        anchors.push_back(anchor(1, 30 * i, 30 * i));
+        anchors.push_back(anchor(2, 30 * i, 30 * i + 7));
+    }
+    anchors.push_back(anchor(1, 5000, 9000));
+
+    chain_anchors(anchors, K, 500, 0, chains, &chained);
+
+    assert(chains.size() == 3);
+    assert(chained.size() == 2 + 11);
+    for (int c = 0; c < 3; ++c) {
+        const chain_t& chain = chains[c];
+        assert(chain.first_anchor >= 2);
+        for (int k = 0; k < chain.anchors; ++k) {
+            const anchor_t& a = chained[chain.first_anchor + k];
+            assert(a.read == chain.read);
+            assert(a.query_pos - a.target_pos >= chain.lo_diagonal);
+            assert(a.query_pos - a.target_pos <= chain.hi_diagonal);
+            if (k > 0) assert(a.target_pos > chained[chain.first_anchor + k - 1].target_pos);
+        }
+    }
+    assert(chains[0].read == 1 && chains[0].anchors == 5 && chained[chains[0].first_anchor].target_pos == 0);
+}
+
+// chains are appended, and an empty set of anchors adds nothing
+void test_append() {
+    std::vector<anchor_t> anchors;
+    std::vector<chain_t> chains(1);
+
+    chain_anchors(anchors, K, 500, 0, chains);
+    assert(chains.size() == 1);
+
+    anchors.push_back(anchor(1, 10, 10));
+    chain_anchors(anchors, K, 500, 0, chains);
+    assert(chains.size() == 2 && chains[1].read == 1);
+}
+
+int main() {
+
+    printf("single diagonal test: ");
+    test_single_diagonal();
+    printf("OK\n");
+
+    printf("drifting diagonal test: ");
+    test_drifting_diagonal();
+    printf("OK\n");
+
+    printf("reads and repeats test: ");
+    test_reads_and_repeats();
+    printf("OK\n");
+
+    printf("min score test: ");
+    test_min_score();
+    printf("OK\n");
+
+    printf("chained anchors test: ");
+    test_chained_anchors();
+    printf("OK\n");
+
+    printf("append test: ");
+    test_append();
+    printf("OK\n");
+
+    return 0;
+}
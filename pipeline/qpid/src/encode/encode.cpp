@@ -0,0 +1,34 @@
+#include "./encode.h"
+#include "../nucleo_buffer/nucleo_buffer.h"
+
+void encode_bases_scalar(const char* str, int len, char* codes) {
+
+    for (int i = 0; i < len; ++i) {
+        codes[i] = nucleo_repr(str[i]);
+    }
+}
+
+typedef void (*encode_fn)(const char*, int, char*);
+
+encode_fn pick_encoder() {
+
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))     return encode_bases_avx2;
+    if (__builtin_cpu_supports("sse4.1"))   return encode_bases_sse41;
+#endif
+    return encode_bases_scalar;
+}
+
+void encode_bases(const char* str, int len, char* codes) {
+
+    static const encode_fn encoder = pick_encoder();
+    encoder(str, len, codes);
+}
+
+void reverse_complement_codes(const char* codes, int len, char* rc) {
+
+    for (int i = 0; i < len; ++i) {
+        rc[i] = 0x3 - codes[len - i - 1];
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef ENCODE_H
+#define ENCODE_H
+
+// Reads are converted to 2-bit base codes (A 0, C 1, G 2, T 3, in either case) once,
+// when they are loaded; anything else becomes A, like in NucleoBuffer. Aligners and
+// minimizers work on the codes, so their hot loops never decode letters.
+// codes may be the same buffer as str.
+void encode_bases(const char* str, int len, char* codes);
+
+// encode_bases for a given instruction set; without it in the build, they fall back to scalar
+void encode_bases_scalar(const char* str, int len, char* codes);
+void encode_bases_sse41(const char* str, int len, char* codes);
+void encode_bases_avx2(const char* str, int len, char* codes);
+
+// reverse complement of 2-bit codes
+void reverse_complement_codes(const char* codes, int len, char* rc);
+
+inline char decode_base(char code) {
+    return "ACGT"[code & 0x3];
+}
+
+#endif
@@ -0,0 +1,34 @@
+// AVX2 build of encode_bases (32 bases at a time).
+#include "./encode.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+struct avx2_encode_ops {
+    typedef __m256i vec;
+    static const int width = 32;
+
+    static inline vec set1(char x)                  { return _mm256_set1_epi8(x); }
+    static inline vec load(const char* p)           { return _mm256_loadu_si256((const __m256i*) p); }
+    static inline void store(char* p, vec v)        { _mm256_storeu_si256((__m256i*) p, v); }
+    static inline vec and_(vec a, vec b)            { return _mm256_and_si256(a, b); }
+    static inline vec cmpeq(vec a, vec b)           { return _mm256_cmpeq_epi8(a, b); }
+    // shuffles within each 128-bit half, so the table is repeated in both
+    static inline vec shuffle(vec t, vec idx)       { return _mm256_shuffle_epi8(t, idx); }
+
+    static inline vec table(char e0, char e1, char e2, char e3, char e4, char e5, char e6, char e7) {
+        return _mm256_setr_epi8(e0, e1, e2, e3, e4, e5, e6, e7, 0, 0, 0, 0, 0, 0, 0, 0,
+                                e0, e1, e2, e3, e4, e5, e6, e7, 0, 0, 0, 0, 0, 0, 0, 0);
+    }
+};
+
+#include "./encode_simd.cpp"
+
+void encode_bases_avx2(const char* str, int len, char* codes) {
+    encode_bases_kernel<avx2_encode_ops>(str, len, codes);
+}
+#else
+void encode_bases_avx2(const char* str, int len, char* codes) {
+    encode_bases_scalar(str, len, codes);
+}
+#endif
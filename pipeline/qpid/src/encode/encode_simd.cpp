@@ -0,0 +1,26 @@
+// Vectorized encode_bases, shared by the SSE4.1 and AVX2 builds like banded_simd.cpp.
+//
+// Low nibbles of A, C, G and T (1, 3, 7, 4) are all different and the same in both
+// cases, so one shuffle on the low nibble gives the code and another one the letter
+// the byte has to be (upper cased) for that code to count; all other bytes become A.
+
+template <typename V>
+void encode_bases_kernel(const char* str, int len, char* codes) {
+
+    typedef typename V::vec vec;
+
+    const vec letters = V::table('\0', 'A', '\0', 'C', 'T', '\0', '\0', 'G');
+    const vec values = V::table(0, 0, 0, 1, 3, 0, 0, 2);
+    const vec low_nibble = V::set1(0x0f);
+    const vec upper = V::set1((char) 0xdf);
+
+    int i = 0;
+    for (; i + V::width <= len; i += V::width) {
+        vec ch = V::and_(V::load(str + i), upper);
+        vec nibble = V::and_(ch, low_nibble);
+        vec known = V::cmpeq(V::shuffle(letters, nibble), ch);
+        V::store(codes + i, V::and_(V::shuffle(values, nibble), known));
+    }
+
+    encode_bases_scalar(str + i, len - i, codes + i);
+}
@@ -0,0 +1,33 @@
+// SSE4.1 build of encode_bases (16 bases at a time).
+#include "./encode.h"
+
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+
+struct sse41_encode_ops {
+    typedef __m128i vec;
+    static const int width = 16;
+
+    static inline vec set1(char x)                  { return _mm_set1_epi8(x); }
+    static inline vec load(const char* p)           { return _mm_loadu_si128((const __m128i*) p); }
+    static inline void store(char* p, vec v)        { _mm_storeu_si128((__m128i*) p, v); }
+    static inline vec and_(vec a, vec b)            { return _mm_and_si128(a, b); }
+    static inline vec cmpeq(vec a, vec b)           { return _mm_cmpeq_epi8(a, b); }
+    static inline vec shuffle(vec t, vec idx)       { return _mm_shuffle_epi8(t, idx); }
+
+    // first eight entries of a 16-entry lookup table, the rest are zero
+    static inline vec table(char e0, char e1, char e2, char e3, char e4, char e5, char e6, char e7) {
+        return _mm_setr_epi8(e0, e1, e2, e3, e4, e5, e6, e7, 0, 0, 0, 0, 0, 0, 0, 0);
+    }
+};
+
+#include "./encode_simd.cpp"
+
+void encode_bases_sse41(const char* str, int len, char* codes) {
+    encode_bases_kernel<sse41_encode_ops>(str, len, codes);
+}
+#else
+void encode_bases_sse41(const char* str, int len, char* codes) {
+    encode_bases_scalar(str, len, codes);
+}
+#endif
@@ -0,0 +1,102 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "./encode.h"
+#include "../nucleo_buffer/nucleo_buffer.h"
+
+typedef void (*encode_fn)(const char*, int, char*);
+
+// every byte value, at every offset from an aligned start, and in place
+void test_encoder(encode_fn fn, const char* name) {
+
+    srand(3);
+
+    for (int iter = 0; iter < 2000; ++iter) {
+        int len = rand() % 200;
+        std::string str(len, 'A');
+        for (int i = 0; i < len; ++i) {
+            str[i] = rand() % 4 ? "ACGTacgtN"[rand() % 9] : rand() % 256;
+        }
+
+        std::vector<char> expected(len + 1), codes(len + 1);
+        encode_bases_scalar(str.c_str(), len, &expected[0]);
+        fn(str.c_str(), len, &codes[0]);
+        assert(std::equal(expected.begin(), expected.begin() + len, codes.begin()));
+
+        fn(&str[0], len, &str[0]);
+        assert(std::equal(expected.begin(), expected.begin() + len, str.begin()));
+    }
+
+    printf("%s matches the scalar encoder\n", name);
+}
+
+void test_scalar() {
+
+    char str[] = "ACGTacgtNnXU-";
+    char codes[sizeof(str)];
+    encode_bases_scalar(str, sizeof(str) - 1, codes);
+
+    const char expected[] = { 0, 1, 2, 3, 0, 1, 2, 3, 0, 0, 0, 0, 0 };
+    for (int i = 0; i < (int) sizeof(str) - 1; ++i) {
+        assert(codes[i] == expected[i]);
+    }
+    for (int i = 0; i < 4; ++i) {
+        assert(decode_base(codes[i]) == str[i]);
+    }
+
+    char rc[8];
+    reverse_complement_codes(codes, 8, rc);
+    const char expected_rc[] = { 0, 1, 2, 3, 0, 1, 2, 3 };
+    for (int i = 0; i < 8; ++i) {
+        assert(rc[i] == expected_rc[i]);
+    }
+
+    printf("scalar encoder test: OK\n");
+}
+
+// rolling over codes gives the k-mers NucleoBuffer gives for letters
+void test_kmer_iterator() {
+
+    srand(5);
+    std::string str(300, 'A');
+    for (int i = 0; i < 300; ++i) {
+        str[i] = "ACGT"[rand() % 4];
+    }
+    std::vector<char> codes(str.size());
+    encode_bases(str.c_str(), str.size(), &codes[0]);
+
+    for (int k = 1; k <= MAX_NSTRING_LEN; ++k) {
+        NucleoBuffer letters(k), rolled(k);
+        KmerIterator<NucleoBuffer> kmers(rolled, &codes[0], codes.size());
+
+        int count = 0;
+        for (int i = 0; i < (int) str.size(); ++i) {
+            letters.write(str[i]);
+            if (i < k - 1) continue;
+
+            assert(kmers.next());
+            assert(kmers.pos() == i - k + 1);
+            assert(rolled.get_content() == letters.get_content());
+            assert(rolled.get_reverse_content() == letters.get_reverse_content());
+            ++count;
+        }
+        assert(!kmers.next());
+        assert(count == (int) str.size() - k + 1);
+    }
+
+    printf("k-mer iterator test: OK\n");
+}
+
+int main() {
+
+    test_scalar();
+    test_encoder(encode_bases_sse41, "sse4.1");
+    test_encoder(encode_bases_avx2, "avx2");
+    test_encoder(encode_bases, "dispatched");
+    test_kmer_iterator();
+
+    return 0;
+}
@@ -1,16 +1,72 @@
+#ifndef FIXED_MIN_QUEUE_H
+#define FIXED_MIN_QUEUE_H
+
 #include <queue>
 #include <list>
+#include <vector>
 
+// Minimum of the last n pushed elements. The monotone deque lives in a ring buffer of
+// n slots allocated by the constructor, so pushing never allocates. Every slot keeps the
+// push number of its element, which tells when the element leaves the window.
 template <typename T>
 class FixedMinQueue {
  public:
-     explicit FixedMinQueue(int n) {
+     explicit FixedMinQueue(int n)
+         : size(n), items(n), stamps(n), first(0), len(0), pushed(0) {
+     }
+
+     void push(T elem) {
+         // front falls out of the window with this push, which also frees its slot
+         if (len > 0 && stamps[first] + size <= pushed) {
+             if (++first == size) first = 0;
+             --len;
+         }
+
+         // drop the bigger ones from the back, they can't be a minimum anymore
+         while (len > 0 && items[back()] > elem) --len;
+
+         int slot = first + len;
+         if (slot >= size) slot -= size;
+         items[slot] = elem;
+         stamps[slot] = pushed++;
+         ++len;
+     }
+
+     T min() {
+         return items[first];
+     }
+
+     void clear() {
+         first = len = 0;
+         pushed = 0;
+     }
+
+ private:
+     int back() const {
+         int slot = first + len - 1;
+         return slot >= size ? slot - size : slot;
+     }
+
+     int size;
+     std::vector<T> items;
+     std::vector<long long> stamps;
+     int first;
+     int len;
+     long long pushed;
+};
+
+// FixedMinQueue as it was before the ring buffer, with a node allocation for every push
+// in both containers. Kept as the reference for test_minq.
+template <typename T>
+class ListMinQueue {
+ public:
+     explicit ListMinQueue(int n) {
          size = n;
          q = new std::list<T>();
          elems = new std::queue<T>();
      }
 
-     ~FixedMinQueue() {
+     ~ListMinQueue() {
          if (q != 0)        delete(q);
          if (elems != 0)    delete(elems);
      }
@@ -44,3 +100,4 @@ class FixedMinQueue {
      std::list<T>* q;
 };
 
+#endif
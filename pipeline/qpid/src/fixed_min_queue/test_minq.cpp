@@ -3,6 +3,7 @@
 #include <cstdlib>
 #include <ctime>
 #include <cassert>
+#include <chrono>
 #include "./fixed_min_queue.cpp"
 
 int min_elem(std::vector<int>& elems, int size) {
@@ -39,13 +40,75 @@ void test(int size, int tries, int maxnum) {
     }
 }
 
+// ring buffer gives the same minima as the list based queue, also after clear
+void test_against_list(int size, int tries, int maxnum) {
+
+    FixedMinQueue<int> ring(size);
+    ListMinQueue<int> list(size);
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < tries; ++i) {
+            int num = rand() % maxnum;
+            ring.push(num);
+            list.push(num);
+            assert(ring.min() == list.min());
+        }
+        ring.clear();
+        list.clear();
+    }
+}
+
+// minimum of every window of 5 16-mers over a random stream of len bases, like the minimizer loop
+template <typename Queue>
+unsigned long long stream_minima(const std::vector<char>& bases, int window, double* seconds) {
+
+    auto start = std::chrono::steady_clock::now();
+
+    Queue q(window);
+    unsigned int kmer = 0;
+    unsigned long long checksum = 0;
+    for (size_t i = 0, len = bases.size(); i < len; ++i) {
+        kmer = (kmer << 2) | bases[i];
+        q.push(kmer ^ 0x33333333);
+        checksum += q.min();
+    }
+
+    *seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return checksum;
+}
+
+void benchmark(int mbp) {
+
+    std::vector<char> bases((size_t) mbp * 1000000);
+    for (size_t i = 0; i < bases.size(); ++i) {
+        bases[i] = rand() & 3;
+    }
+
+    double ring_seconds, list_seconds;
+    unsigned long long ring_sum = stream_minima<FixedMinQueue<unsigned int>>(bases, 5, &ring_seconds);
+    unsigned long long list_sum = stream_minima<ListMinQueue<unsigned int>>(bases, 5, &list_seconds);
+    assert(ring_sum == list_sum);
+
+    printf("%d Mbp stream, window of 5: ring buffer %.2lfs (%.1lf Mbp/s), list %.2lfs (%.1lf Mbp/s)\n",
+        mbp, ring_seconds, mbp / ring_seconds, list_seconds, mbp / list_seconds);
+}
+
 int main(int argc, char** argv) {
 
+    if (argc < 2) {
+        printf("Usage: %s tests [benchmark Mbp]\n", argv[0]);
+        exit(1);
+    }
+
     srand(time(NULL));
     for (int i = 0, tests = atoi(argv[1]); i < tests; ++i) {
         test(5, 200, (i % 100) + 1);
+        test_against_list(1 + i % 30, 1000, (i % 100) + 1);
         printf("Test %d passed.\n", i);
     }
 
+    if (argc > 2) {
+        benchmark(atoi(argv[2]));
+    }
+
     return 0;
 }
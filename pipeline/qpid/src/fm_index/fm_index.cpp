@@ -0,0 +1,149 @@
+#include "./fm_index.h"
+#include "./sais.h"
+#include <cassert>
+#include <climits>
+#include <algorithm>
+
+FMIndex::FMIndex() {
+    std::fill(_counts, _counts + SYMBOLS + 1, 0);
+}
+
+void FMIndex::build(const ReadStore& reads) {
+
+    unsigned long long len = 2 + 2 * (reads.bases() + reads.size());
+    assert(len < INT_MAX);
+
+    // bases are 2 to 5, after the sentinel and the separator
+    std::vector<int> text(len);
+    std::vector<char> codes;
+    unsigned int pos = 0;
+    text[pos++] = SEPARATOR;
+    _starts.clear();
+    for (unsigned int i = 0; i < reads.size(); ++i) {
+        for (int forward = 1; forward >= 0; --forward) {
+            const Read read = forward ? reads.get(i, codes) : reads.get_reverse_complement(i, codes);
+            _starts.push_back(pos);
+            for (int j = 0; j < read.length; ++j) {
+                text[pos++] = read.codes[j] + 2;
+            }
+            text[pos++] = SEPARATOR;
+        }
+    }
+    text[pos++] = 0;
+    assert(pos == len);
+
+    _sa.resize(len);
+    sais(text.data(), (int*) _sa.data(), len, SYMBOLS);
+
+    _text.assign(text.begin(), text.end());
+    std::vector<int>().swap(text);
+
+    _bwt.resize(len);
+    for (unsigned int i = 0; i < len; ++i) {
+        _bwt[i] = _text[_sa[i] > 0 ? _sa[i] - 1 : len - 1];
+    }
+
+    // counts of every symbol before each sampled position
+    unsigned int samples = len / OCC_SAMPLE + 1;
+    _occ.assign((size_t) samples * SYMBOLS, 0);
+    unsigned int counts[SYMBOLS] = { 0 };
+    for (unsigned int i = 0; i < len; ++i) {
+        if (i % OCC_SAMPLE == 0) std::copy(counts, counts + SYMBOLS, &_occ[(size_t) i / OCC_SAMPLE * SYMBOLS]);
+        ++counts[_bwt[i]];
+    }
+    if (len % OCC_SAMPLE == 0) std::copy(counts, counts + SYMBOLS, &_occ[(size_t) len / OCC_SAMPLE * SYMBOLS]);
+
+    _counts[0] = 0;
+    for (int c = 0; c < SYMBOLS; ++c) {
+        _counts[c + 1] = _counts[c] + counts[c];
+    }
+}
+
+size_t FMIndex::memory() const {
+    return _text.size() + _bwt.size() + (_sa.size() + _occ.size() + _starts.size()) * sizeof(unsigned int);
+}
+
+unsigned int FMIndex::occ(int symbol, unsigned int i) const {
+    unsigned int sample = i / OCC_SAMPLE;
+    unsigned int count = _occ[(size_t) sample * SYMBOLS + symbol];
+    for (unsigned int j = sample * OCC_SAMPLE; j < i; ++j) {
+        count += _bwt[j] == symbol;
+    }
+    return count;
+}
+
+FMIndex::interval_t FMIndex::extend(const interval_t& interval, int symbol) const {
+    interval_t extended;
+    extended.lo = _counts[symbol] + occ(symbol, interval.lo);
+    extended.hi = _counts[symbol] + occ(symbol, interval.hi);
+    return extended;
+}
+
+unsigned int FMIndex::string_at(unsigned int pos) const {
+    unsigned int string = std::upper_bound(_starts.begin(), _starts.end(), pos) - _starts.begin() - 1;
+    assert(_starts[string] == pos);
+    return string;
+}
+
+int FMIndex::string_length(unsigned int string) const {
+    unsigned int end = string + 1 < _starts.size() ? _starts[string + 1] : _text.size() - 1;
+    return end - 1 - _starts[string];
+}
+
+void FMIndex::overlaps(const char* codes, int len, int min_length, std::vector<match_t>& matches) const {
+
+    static thread_local std::vector<match_t> found;
+    found.clear();
+
+    // suffixes of the query from the shortest on; the ones after a separator are prefixes
+    // of strings
+    interval_t interval = { 0, (unsigned int) _bwt.size() };
+    for (int i = len - 1; i >= 1; --i) {
+        interval = extend(interval, codes[i] + 2);
+        if (interval.lo >= interval.hi) break;
+
+        int length = len - i;
+        if (length < min_length) continue;
+
+        interval_t starts = extend(interval, SEPARATOR);
+        for (unsigned int j = starts.lo; j < starts.hi; ++j) {
+            match_t match;
+            match.string = string_at(_sa[j] + 1);
+            match.length = length;
+            if (length < string_length(match.string)) found.push_back(match);
+        }
+    }
+
+    // the longest overlap with each string
+    std::sort(found.begin(), found.end(), [] (const match_t& a, const match_t& b) {
+        if (a.string != b.string) return a.string < b.string;
+        return a.length > b.length;
+    });
+    found.erase(std::unique(found.begin(), found.end(), [] (const match_t& a, const match_t& b) {
+        return a.string == b.string;
+    }), found.end());
+    std::sort(found.begin(), found.end(), [] (const match_t& a, const match_t& b) {
+        if (a.length != b.length) return a.length > b.length;
+        return a.string < b.string;
+    });
+
+    // a string is reached through a longer overlap when what the longer one adds after the
+    // query is a proper prefix of what this one adds
+    size_t first = matches.size();
+    for (const match_t& match : found) {
+        int rest = string_length(match.string) - match.length;
+        const unsigned char* after = &_text[_starts[match.string] + match.length];
+
+        bool reducible = false;
+        for (size_t k = first; k < matches.size() && !reducible; ++k) {
+            const match_t& longer = matches[k];
+            int longer_rest = string_length(longer.string) - longer.length;
+            if (longer.length == match.length || longer_rest >= rest) continue;
+
+            const unsigned char* longer_after = &_text[_starts[longer.string] + longer.length];
+            reducible = std::equal(longer_after, longer_after + longer_rest, after);
+        }
+
+        if (!reducible) matches.push_back(match);
+    }
+}
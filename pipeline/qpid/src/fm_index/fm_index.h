@@ -0,0 +1,70 @@
+#ifndef FM_INDEX_H
+#define FM_INDEX_H
+
+#include <cstddef>
+#include <vector>
+#include "../read_store/read_store.h"
+
+// FM-index of all reads and their reverse complements, for exact suffix-prefix overlaps like
+// in SGA (Simpson and Durbin, 2010). String 2i is read i and string 2i + 1 its reverse
+// complement; the text is $ s0 $ s1 $ ... $ s(2n - 1) $ with a smaller sentinel after it, and
+// its suffix array is built with SA-IS. Occurrences of symbols in the BWT are counted at
+// every OCC_SAMPLE-th position, and the suffix array is kept whole, for locating matches.
+class FMIndex {
+ public:
+    // a string whose prefix is a suffix of the query, and the length of that overlap
+    struct match_t {
+        unsigned int string;
+        int length;
+    };
+
+    FMIndex();
+
+    void build(const ReadStore& reads);
+
+    unsigned int strings() const {
+        return _starts.size();
+    }
+
+    // text length, with separators and the sentinel
+    size_t size() const {
+        return _bwt.size();
+    }
+
+    size_t memory() const;
+
+    // Appends the irreducible overlaps of the query (2-bit codes) with strings, at least
+    // min_length long, longest first: the longest one with every string whose prefix is a
+    // proper suffix of the query, leaving out the strings it reaches through a longer overlap.
+    // Strings containing the query, or contained in it, are left out too.
+    void overlaps(const char* codes, int len, int min_length, std::vector<match_t>& matches) const;
+
+ private:
+    // sentinel, separator and the 4 bases
+    static const int SYMBOLS = 6;
+    static const int SEPARATOR = 1;
+    static const unsigned int OCC_SAMPLE = 64;
+
+    struct interval_t {
+        unsigned int lo;
+        unsigned int hi;
+    };
+
+    // occurrences of the symbol in the BWT before position i
+    unsigned int occ(int symbol, unsigned int i) const;
+    // interval of the suffixes starting with the symbol followed by the ones of the interval
+    interval_t extend(const interval_t& interval, int symbol) const;
+
+    // string that starts at the position of the text
+    unsigned int string_at(unsigned int pos) const;
+    int string_length(unsigned int string) const;
+
+    std::vector<unsigned char> _text;
+    std::vector<unsigned char> _bwt;
+    std::vector<unsigned int> _sa;
+    std::vector<unsigned int> _occ;
+    std::vector<unsigned int> _starts;
+    unsigned int _counts[SYMBOLS + 1];
+};
+
+#endif
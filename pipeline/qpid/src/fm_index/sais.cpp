@@ -0,0 +1,113 @@
+#include "./sais.h"
+#include <vector>
+
+// starts (or ends, exclusive) of the bucket of every symbol in the suffix array
+static void get_buckets(const int* s, int n, int alphabet, std::vector<int>& buckets, bool ends) {
+    buckets.assign(alphabet, 0);
+    for (int i = 0; i < n; ++i) {
+        ++buckets[s[i]];
+    }
+
+    int sum = 0;
+    for (int c = 0; c < alphabet; ++c) {
+        sum += buckets[c];
+        buckets[c] = ends ? sum : sum - buckets[c];
+    }
+}
+
+// L-type suffixes follow from sorted ones left to right, S-type ones right to left
+static void induce(const int* s, int* sa, int n, int alphabet, const std::vector<bool>& stype,
+        std::vector<int>& buckets) {
+
+    get_buckets(s, n, alphabet, buckets, false);
+    for (int i = 0; i < n; ++i) {
+        int j = sa[i] - 1;
+        if (sa[i] > 0 && !stype[j]) sa[buckets[s[j]]++] = j;
+    }
+
+    get_buckets(s, n, alphabet, buckets, true);
+    for (int i = n - 1; i >= 0; --i) {
+        int j = sa[i] - 1;
+        if (sa[i] > 0 && stype[j]) sa[--buckets[s[j]]] = j;
+    }
+}
+
+void sais(const int* s, int* sa, int n, int alphabet) {
+
+    if (n == 1) {
+        sa[0] = 0;
+        return;
+    }
+
+    // suffix i is S-type if it is smaller than suffix i + 1
+    std::vector<bool> stype(n);
+    stype[n - 1] = true;
+    for (int i = n - 2; i >= 0; --i) {
+        stype[i] = s[i] < s[i + 1] || (s[i] == s[i + 1] && stype[i + 1]);
+    }
+    auto lms = [&stype] (int i) {
+        return i > 0 && stype[i] && !stype[i - 1];
+    };
+
+    // LMS suffixes at the ends of their buckets sort the LMS substrings
+    std::vector<int> buckets;
+    get_buckets(s, n, alphabet, buckets, true);
+    for (int i = 0; i < n; ++i) sa[i] = -1;
+    for (int i = 1; i < n; ++i) {
+        if (lms(i)) sa[--buckets[s[i]]] = i;
+    }
+    induce(s, sa, n, alphabet, stype, buckets);
+
+    // sorted LMS substrings go to the front, and get names in the order they are in
+    int n1 = 0;
+    for (int i = 0; i < n; ++i) {
+        if (lms(sa[i])) sa[n1++] = sa[i];
+    }
+    for (int i = n1; i < n; ++i) sa[i] = -1;
+
+    int names = 0;
+    int prev = -1;
+    for (int i = 0; i < n1; ++i) {
+        int pos = sa[i];
+        bool differ = false;
+        for (int d = 0; ; ++d) {
+            if (prev == -1 || s[pos + d] != s[prev + d] || stype[pos + d] != stype[prev + d]) {
+                differ = true;
+                break;
+            }
+            if (d > 0 && (lms(pos + d) || lms(prev + d))) break;
+        }
+        if (differ) {
+            ++names;
+            prev = pos;
+        }
+        // LMS positions are at least 2 apart
+        sa[n1 + pos / 2] = names - 1;
+    }
+    for (int i = n - 1, j = n - 1; i >= n1; --i) {
+        if (sa[i] >= 0) sa[j--] = sa[i];
+    }
+
+    // the names, in the order of the LMS substrings in the text, are the reduced text
+    int* s1 = sa + n - n1;
+    int* sa1 = sa;
+    if (names < n1) {
+        sais(s1, sa1, n1, names);
+    } else {
+        for (int i = 0; i < n1; ++i) sa1[s1[i]] = i;
+    }
+
+    // sorted LMS suffixes induce all the others
+    get_buckets(s, n, alphabet, buckets, true);
+    for (int i = 1, j = 0; i < n; ++i) {
+        if (lms(i)) s1[j++] = i;
+    }
+    for (int i = 0; i < n1; ++i) sa1[i] = s1[sa1[i]];
+    for (int i = n1; i < n; ++i) sa[i] = -1;
+    for (int i = n1 - 1; i >= 0; --i) {
+        int j = sa[i];
+        sa[i] = -1;
+        sa[--buckets[s[j]]] = j;
+    }
+    induce(s, sa, n, alphabet, stype, buckets);
+}
@@ -0,0 +1,9 @@
+#ifndef SAIS_H
+#define SAIS_H
+
+// Suffix array by induced sorting (SA-IS, Nong, Zhang and Chan 2009), linear in the length
+// of the text. Symbols of the text are in [0, alphabet), and the last one has to be 0, the
+// only 0 in the text. sa gets the start of every suffix, in lexicographic order.
+void sais(const int* text, int* sa, int n, int alphabet);
+
+#endif
@@ -0,0 +1,172 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "./fm_index.h"
+#include "./sais.h"
+#include "../encode/encode.h"
+
+std::string random_string(int len, const char* alphabet, int size) {
+    std::string str(len, alphabet[0]);
+    for (int i = 0; i < len; ++i) {
+        str[i] = alphabet[rand() % size];
+    }
+    return str;
+}
+
+std::string reverse_complement(const std::string& str) {
+    std::string rc(str.rbegin(), str.rend());
+    for (char& c : rc) {
+        c = c == 'A' ? 'T' : c == 'C' ? 'G' : c == 'G' ? 'C' : 'A';
+    }
+    return rc;
+}
+
+// the same order as sorting the suffixes
+void test_sais(int len, int alphabet) {
+    std::vector<int> text(len + 1);
+    for (int i = 0; i < len; ++i) {
+        text[i] = 1 + rand() % (alphabet - 1);
+    }
+    text[len] = 0;
+
+    std::vector<int> sa(len + 1), expected(len + 1);
+    sais(text.data(), sa.data(), len + 1, alphabet);
+
+    for (int i = 0; i <= len; ++i) expected[i] = i;
+    std::sort(expected.begin(), expected.end(), [&text] (int a, int b) {
+        return std::lexicographical_compare(text.begin() + a, text.end(), text.begin() + b, text.end());
+    });
+    assert(sa == expected);
+}
+
+std::vector<char> codes_of(const std::string& str) {
+    std::vector<char> codes(str.size() + 1);
+    encode_bases(str.c_str(), str.size(), &codes[0]);
+    return codes;
+}
+
+// longest proper suffix-prefix overlap of a with b, at least min_length long, or 0
+int longest_overlap(const std::string& a, const std::string& b, int min_length) {
+    for (int len = std::min(a.size() - 1, b.size() - 1); len >= min_length; --len) {
+        if (a.compare(a.size() - len, len, b, 0, len) == 0) return len;
+    }
+    return 0;
+}
+
+// every overlap is found, and only the ones reached through a longer overlap are left out
+void test_overlaps(int reads_num, int genome_len, int read_len, int min_length) {
+    std::string genome = random_string(genome_len, "ACGT", 4);
+    std::vector<std::string> strings;
+    ReadStore reads;
+    for (int i = 0; i < reads_num; ++i) {
+        int len = read_len / 2 + rand() % read_len;
+        int start = rand() % (genome_len - len);
+        std::string read = genome.substr(start, len);
+        if (rand() % 2) read = reverse_complement(read);
+
+        reads.add(i, read.c_str(), read.size());
+        strings.push_back(read);
+        strings.push_back(reverse_complement(read));
+    }
+
+    FMIndex index;
+    index.build(reads);
+    assert(index.strings() == strings.size());
+
+    std::vector<FMIndex::match_t> matches;
+    for (int q = 0; q < (int) strings.size(); ++q) {
+        const std::string& query = strings[q];
+        std::vector<char> codes = codes_of(query);
+        matches.clear();
+        index.overlaps(&codes[0], query.size(), min_length, matches);
+
+        std::vector<int> expected(strings.size());
+        for (int s = 0; s < (int) strings.size(); ++s) {
+            expected[s] = longest_overlap(query, strings[s], min_length);
+            if (query.size() >= strings[s].size() && expected[s] > 0) {
+                // the query contains the string, the overlap is a proper one still
+                assert(expected[s] < (int) strings[s].size());
+            }
+        }
+
+        std::vector<bool> returned(strings.size(), false);
+        for (size_t m = 0; m < matches.size(); ++m) {
+            assert(matches[m].length == expected[matches[m].string]);
+            assert(m == 0 || matches[m - 1].length >= matches[m].length);
+            returned[matches[m].string] = true;
+        }
+
+        // a left out string follows a returned one, which ends before it
+        for (int s = 0; s < (int) strings.size(); ++s) {
+            if (expected[s] == 0 || returned[s]) continue;
+            int rest = strings[s].size() - expected[s];
+
+            bool reached = false;
+            for (const auto& match : matches) {
+                const std::string& longer = strings[match.string];
+                int longer_rest = longer.size() - match.length;
+                if (match.length > expected[s] && longer_rest < rest &&
+                    longer.compare(match.length, longer_rest, strings[s], expected[s], longer_rest) == 0) {
+                    reached = true;
+                }
+            }
+            assert(reached);
+        }
+    }
+}
+
+// reads tiling a genome overlap only the next one, by the length they share
+void test_tiling() {
+    std::string genome = random_string(2000, "ACGT", 4);
+    ReadStore reads;
+    for (int i = 0; i < 10; ++i) {
+        std::string read = genome.substr(150 * i, 400);
+        reads.add(i, read.c_str(), read.size());
+    }
+
+    FMIndex index;
+    index.build(reads);
+
+    std::vector<FMIndex::match_t> matches;
+    for (int i = 0; i < 9; ++i) {
+        std::string read = genome.substr(150 * i, 400);
+        std::vector<char> codes = codes_of(read);
+        matches.clear();
+        index.overlaps(&codes[0], read.size(), 50, matches);
+        assert(matches.size() == 1);
+        assert(matches[0].string == 2u * (i + 1) && matches[0].length == 250);
+
+        // the next but one overlaps by 100, only a shorter minimum finds it at all
+        matches.clear();
+        index.overlaps(&codes[0], read.size(), 260, matches);
+        assert(matches.empty());
+    }
+}
+
+int main() {
+
+    srand(5);
+
+    printf("sais test: ");
+    test_sais(0, 2);
+    test_sais(1, 2);
+    test_sais(1000, 2);
+    test_sais(1000, 3);
+    test_sais(10000, 6);
+    for (int i = 0; i < 100; ++i) test_sais(rand() % 100, 2 + rand() % 4);
+    printf("OK\n");
+
+    printf("tiling test: ");
+    test_tiling();
+    printf("OK\n");
+
+    printf("overlaps test: ");
+    test_overlaps(50, 600, 100, 10);
+    test_overlaps(200, 3000, 200, 20);
+    printf("OK\n");
+
+    return 0;
+}
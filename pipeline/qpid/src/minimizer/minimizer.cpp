@@ -5,7 +5,29 @@
 #include <vector>
 #include <utility>
 #include <algorithm>
-#include "../hash_list/hash_list.cpp"
+#include <future>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "thread_pool/ThreadPool.h"
+
+// upper bound on blocks of strings, each of them is a task and a block of the index
+const unsigned int STORE_BLOCKS = 64;
+
+// start of a saved index file, followed by the index itself (see MinimizerIndex::save)
+struct saved_minimizers_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t minimizer_len;
+    uint32_t window_len;
+    uint32_t reads;
+    uint64_t bases;
+};
+
+const char SAVED_MINIMIZERS_MAGIC[8] = { 'Q', 'P', 'I', 'D', 'I', 'D', 'X', 0 };
+const uint32_t SAVED_MINIMIZERS_VERSION = 1;
 
 bool operator==(const minimizer_t& lhs, const minimizer_t& rhs) {
     return lhs.pos == rhs.pos && lhs.str == rhs.str;
@@ -27,83 +49,220 @@ bool operator!=(const minimizer_t& lhs, const minimizer_t& rhs) {
     return !operator==(lhs, rhs);
 }
 
-Minimizer::Minimizer(int mlen, int wlen) {
-    assert(mlen <= wlen);
-    minimizer_len = mlen;
-    window_len = wlen;
-    buff = new NucleoBuffer(mlen);
-    q = new FixedMinQueue<minimizer_t>(wlen - mlen + 1);
+// canonical minimizer of the k-mer the buffer holds
+template <typename Buffer>
+inline minimizer_t canonical_minimizer(Buffer& buff, int pos) {
+    bool forward;
+    nstring_t str = buff.get_canonical_content(&forward);
+    return minimizer_t(str, pos, forward);
 }
 
-Minimizer::~Minimizer() {
-    if (buff != 0)  delete(buff);
-    if (q != 0)     delete(q);
-}
+// Appends minimizers of the 2-bit codes to container. Buffer is a NucleoBuffer, or a StaticNucleoBuffer
+// when minimizer_len and window_len are compile-time constants too (see specialized_kernel).
+template <typename Buffer>
+inline void find_minimizers(Buffer& buff, int minimizer_len, int window_len, const char* codes, int len,
+        std::vector<minimizer_t>& container) {
 
-void  Minimizer::calculate_and_store(int str_index, const char *str) {
-    int len = strlen(str);
-    assert(len >= window_len);
+    // too short to have a single window
+    if (len < window_len) return;
 
-    q->clear();
-
-    for (int i = 0; i < minimizer_len; ++i) {
-        buff->write(str[i]);
-    }
-    q->push(minimizer_t(buff->get_content(), 0));
+    FixedMinQueue<minimizer_t> q(window_len - minimizer_len + 1);
+    KmerIterator<Buffer> kmers(buff, codes, len);
 
-    for (int i = minimizer_len; i < window_len; ++i) {
-        buff->write(str[i]);
-        q->push(minimizer_t(buff->get_content(), i - minimizer_len + 1));
+    // k-mers of the first window
+    for (int i = minimizer_len; i <= window_len; ++i) {
+        kmers.next();
+        q.push(canonical_minimizer(buff, kmers.pos()));
     }
 
-    minimizer_t prev = q->min();
-    this->minimizers.add(prev.str, std::make_pair(str_index, prev.pos));
+    minimizer_t prev = q.min();
+    container.push_back(prev);
 
-    for (int i = window_len; i < len; ++i) {
-        buff->write(str[i]);
-        q->push(minimizer_t(buff->get_content(), i - minimizer_len + 1));
-        if (q->min() != prev) {
-            prev = q->min();
-            this->minimizers.add(prev.str, std::make_pair(str_index, prev.pos));
+    while (kmers.next()) {
+        q.push(canonical_minimizer(buff, kmers.pos()));
+        if (q.min() != prev) {
+            prev = q.min();
+            container.push_back(prev);
         }
     }
 }
 
-void Minimizer::calculate_and_get(std::vector<minimizer_t>& container, const char *str) {
-    int len = strlen(str);
-    assert(len >= window_len);
-
-    // we need it here to have a thread safe implementation
-    FixedMinQueue<minimizer_t> q(window_len - minimizer_len + 1);
+void generic_kernel(int minimizer_len, int window_len, const char* codes, int len,
+        std::vector<minimizer_t>& container) {
     NucleoBuffer buff(minimizer_len);
+    find_minimizers(buff, minimizer_len, window_len, codes, len, container);
+}
 
-    for (int i = 0; i < minimizer_len; ++i) {
-        buff.write(str[i]);
+template <int K, int W>
+void specialized_kernel(int, int, const char* codes, int len, std::vector<minimizer_t>& container) {
+    StaticNucleoBuffer<K> buff;
+    find_minimizers(buff, K, W, codes, len, container);
+}
+
+struct kernel_entry_t {
+    int minimizer_len;
+    int window_len;
+    minimizer_kernel_t kernel;
+};
+
+// windows of 5 and 10 k-mers (qpid's default and minimap's) for the usual k-mer lengths
+#define SPECIALIZED_KERNELS(K) \
+    { K, K + 4, specialized_kernel<K, K + 4> }, \
+    { K, K + 9, specialized_kernel<K, K + 9> }
+
+const kernel_entry_t KERNELS[] = {
+    SPECIALIZED_KERNELS(12),
+    SPECIALIZED_KERNELS(15),
+    SPECIALIZED_KERNELS(16),
+    SPECIALIZED_KERNELS(19),
+    SPECIALIZED_KERNELS(21),
+    SPECIALIZED_KERNELS(24),
+    SPECIALIZED_KERNELS(28),
+    SPECIALIZED_KERNELS(32)
+};
+
+Minimizer::Minimizer(int mlen, int wlen) : minimizers(2 * mlen), mapped(NULL), mapped_len(0) {
+    assert(mlen > 0 && mlen <= MAX_NSTRING_LEN && mlen <= wlen);
+    minimizer_len = mlen;
+    window_len = wlen;
+
+    kernel = generic_kernel;
+    for (const kernel_entry_t& entry : KERNELS) {
+        if (entry.minimizer_len == mlen && entry.window_len == wlen) kernel = entry.kernel;
     }
-    q.push(minimizer_t(buff.get_content(), 0));
+}
 
-    for (int i = minimizer_len; i < window_len; ++i) {
-        buff.write(str[i]);
-        q.push(minimizer_t(buff.get_content(), i - minimizer_len + 1));
+Minimizer::~Minimizer() {
+    if (mapped != NULL) munmap((void*) mapped, mapped_len);
+}
+
+void Minimizer::calculate_and_store(int str_index, const char *codes, int len) {
+    std::vector<minimizer_t> container;
+    kernel(minimizer_len, window_len, codes, len, container);
+
+    for (const minimizer_t& m : container) {
+        minimizers.add(m.str, str_index, m.pos, m.forward);
     }
+}
 
-    minimizer_t prev = q.min();
-    container.push_back(prev);
+void Minimizer::calculate_and_store(const ReadStore& reads, ThreadPool* pool, unsigned int first_read) {
 
-    for (int i = window_len; i < len; ++i) {
-        buff.write(str[i]);
-        q.push(minimizer_t(buff.get_content(), i - minimizer_len + 1));
-        if (q.min() != prev) {
-            prev = q.min();
-            container.push_back(prev);
-        }
+    unsigned int n = reads.size() - first_read;
+    unsigned int blocks = std::min(n, STORE_BLOCKS);
+    minimizers.set_blocks(blocks);
+
+    std::vector<std::future<void>> results;
+    for (unsigned int b = 0; b < blocks; ++b) {
+        results.push_back(pool->enqueue([this, &reads, first_read, n, blocks, b] () {
+            static thread_local std::vector<minimizer_t> container;
+            static thread_local std::vector<char> codes;
+
+            unsigned int first = first_read + (unsigned long long) n * b / blocks;
+            unsigned int last = first_read + (unsigned long long) n * (b + 1) / blocks;
+
+            for (unsigned int i = first; i < last; ++i) {
+                container.clear();
+                const Read read = reads.get(i, codes);
+                calculate_and_get(container, read.codes, read.length);
+                for (const minimizer_t& m : container) {
+                    minimizers.add_to_block(b, m.str, i, m.pos, m.forward);
+                }
+            }
+        }));
     }
+
+    for (unsigned int b = 0; b < blocks; ++b) {
+        results[b].get();
+    }
+}
+
+void Minimizer::calculate_and_get(std::vector<minimizer_t>& container, const char *codes, int len) {
+    kernel(minimizer_len, window_len, codes, len, container);
 }
 
-void Minimizer::shrink() {
-    minimizers.shrink();
+void Minimizer::freeze(ThreadPool* pool) {
+    minimizers.freeze(pool);
 }
 
-const HashList<nstring_t, std::pair<unsigned int, unsigned int> >& Minimizer::get_minimizers() const {
+void Minimizer::merge(const Minimizer& older) {
+    assert(older.minimizer_len == minimizer_len && older.window_len == window_len);
+    minimizers.merge(older.minimizers);
+}
+
+void Minimizer::mask(unsigned int max_occurrences) {
+    minimizers.mask(max_occurrences);
+}
+
+const MinimizerIndex& Minimizer::get_minimizers() const {
     return minimizers;
 }
+
+int Minimizer::get_minimizer_len() const {
+    return minimizer_len;
+}
+
+int Minimizer::get_window_len() const {
+    return window_len;
+}
+
+bool Minimizer::is_specialized() const {
+    return kernel != generic_kernel;
+}
+
+int Minimizer::save(const char* filename, unsigned int reads, unsigned long long bases) const {
+    FILE* out = fopen(filename, "wb");
+    if (out == NULL) return -1;
+
+    saved_minimizers_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SAVED_MINIMIZERS_MAGIC, sizeof(header.magic));
+    header.version = SAVED_MINIMIZERS_VERSION;
+    header.minimizer_len = minimizer_len;
+    header.window_len = window_len;
+    header.reads = reads;
+    header.bases = bases;
+
+    bool written = fwrite(&header, sizeof(header), 1, out) == 1 && minimizers.save(out);
+    if (fclose(out) != 0) written = false;
+
+    return written ? 0 : -1;
+}
+
+int Minimizer::load(const char* filename, unsigned int reads, unsigned long long bases) {
+    assert(mapped == NULL);
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(saved_minimizers_t)) {
+        close(fd);
+        return -1;
+    }
+
+    // shared, so that runs on the same index share its pages
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return -1;
+
+    mapped = (const char*) data;
+    mapped_len = st.st_size;
+
+    saved_minimizers_t header;
+    memcpy(&header, mapped, sizeof(header));
+
+    bool valid = memcmp(header.magic, SAVED_MINIMIZERS_MAGIC, sizeof(header.magic)) == 0 &&
+        header.version == SAVED_MINIMIZERS_VERSION &&
+        header.minimizer_len == (uint32_t) minimizer_len && header.window_len == (uint32_t) window_len &&
+        header.reads == reads && header.bases == bases &&
+        minimizers.map(mapped + sizeof(header), mapped_len - sizeof(header));
+
+    if (!valid) {
+        munmap(data, mapped_len);
+        mapped = NULL;
+        mapped_len = 0;
+        return -1;
+    }
+
+    return 0;
+}
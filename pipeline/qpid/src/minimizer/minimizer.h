@@ -4,34 +4,66 @@
 #include <cstdlib>
 #include <vector>
 #include <utility>
-#include <unordered_map>
 #include "../nucleo_buffer/nucleo_buffer.h"
 #include "../fixed_min_queue/fixed_min_queue.cpp"
-#include "../hash_list/hash_list.cpp"
+#include "../minimizer_index/minimizer_index.h"
+#include "../read_store/read_store.h"
 
+class ThreadPool;
+
+// minimizers are canonical: str is the smaller of the k-mer and its reverse complement,
+// forward tells whether it is the k-mer as it appears in the read
 struct minimizer_t {
     unsigned int pos;
     nstring_t str;
     nstring_t ordstr;
-    minimizer_t(nstring_t str, int pos) : pos(pos), str(str) {
+    bool forward;
+    minimizer_t() : pos(0), str(0), ordstr(0), forward(true) {}
+    minimizer_t(nstring_t str, int pos, bool forward = true) : pos(pos), str(str), forward(forward) {
         // invert some bits
-        ordstr = str ^ 0x33333333;
+        ordstr = str ^ 0x3333333333333333ull;
     }
 };
 
+// appends minimizers of the 2-bit codes (see encode_bases) to container, in order of position
+typedef void (*minimizer_kernel_t)(int minimizer_len, int window_len, const char* codes, int len,
+        std::vector<minimizer_t>& container);
+
+// Minimizers of minimizer_len bases, the smallest one in every window_len bases; common
+// (minimizer_len, window_len) pairs get kernels specialized at compile time.
 class Minimizer {
  public:
      explicit Minimizer(int minimizer_len, int window_len);
      ~Minimizer();
-     void calculate_and_store(int str_index, const char *str);
-     void calculate_and_get(std::vector<minimizer_t>& container, const char *str);
-     const HashList<nstring_t, std::pair<unsigned int, unsigned int> >& get_minimizers() const;
-     void shrink();
+     // sequences are 2-bit codes, see encode_bases
+     void calculate_and_store(int str_index, const char *codes, int len);
+     // stores minimizers of the reads of the store from first on, read i under index i;
+     // blocks of reads are unpacked and done in parallel on the pool
+     void calculate_and_store(const ReadStore& reads, ThreadPool* pool, unsigned int first = 0);
+     void calculate_and_get(std::vector<minimizer_t>& container, const char *codes, int len);
+     // builds the index from everything stored so far, has to be called before get_minimizers
+     void freeze(ThreadPool* pool = NULL);
+     // adds the frozen index of older reads to this frozen one (see MinimizerIndex::merge)
+     void merge(const Minimizer& older);
+     // see MinimizerIndex::mask
+     void mask(unsigned int max_occurrences);
+     const MinimizerIndex& get_minimizers() const;
+     int get_minimizer_len() const;
+     int get_window_len() const;
+     // whether there is a kernel specialized for this minimizer and window length
+     bool is_specialized() const;
+     // writes the frozen index to a file load can map; reads and bases identify the read set
+     int save(const char* filename, unsigned int reads, unsigned long long bases) const;
+     // maps an index saved with the same minimizer and window length and for the same read
+     // set, read-only, instead of calculating it; -1 if that is not possible
+     int load(const char* filename, unsigned int reads, unsigned long long bases);
  private:
      int minimizer_len;
      int window_len;
-     NucleoBuffer* buff;
-     FixedMinQueue<minimizer_t>* q;
-     HashList<nstring_t, std::pair<unsigned int, unsigned int> > minimizers;
+     minimizer_kernel_t kernel;
+     MinimizerIndex minimizers;
+     // file the index is mapped from, see load
+     const char* mapped;
+     size_t mapped_len;
 };
 #endif
@@ -1,30 +1,33 @@
 #include "./minimizer.h"
-#include <zlib.h>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <string>
 #include <vector>
 #include <algorithm>
-#include "../parser/parser.h"
+#include "../encode/encode.h"
 using std::vector;
 
-typedef HashList<nstring_t, std::pair<unsigned int, unsigned int>> minimizers_t;
+typedef MinimizerIndex minimizers_t;
 
-// init fasta/fastq reader
-KSEQ_INIT(gzFile, gzread)
-
-void read_file(vector<const char *>* string_list, const char *filename) {
-    gzFile fp = gzopen(filename, "r");      // STEP 2: open the file handler
-    kseq_t *seq = kseq_init(fp);            // STEP 3: initialize seq
+// reads the sequences of a fasta file, one string per record
+void read_file(vector<std::string>* string_list, const char *filename) {
+    FILE* fp = fopen(filename, "r");
+    if (fp == NULL) {
+        perror(filename);
+        exit(1);
+    }
 
-    int len = 0;
-    while ((len = kseq_read(seq)) > 0) {    // STEP 4: read sequence
-        char *read_string = (char *) malloc(len * sizeof(char));
-        memcpy(read_string, seq->seq.s, len);
-        string_list->push_back(read_string);
+    char line[4096];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (line[0] == '>') {
+            string_list->push_back(std::string());
+        } else if (!string_list->empty()) {
+            string_list->back().append(line, strcspn(line, "\r\n"));
+        }
     }
 
-    kseq_destroy(seq);      // STEP 5: destroy seq
-    gzclose(fp);            // STEP 6: close the file handler
+    fclose(fp);
 }
 
 int main(int argc, char** argv) {
@@ -34,22 +37,25 @@ int main(int argc, char** argv) {
         exit(1);
     }
 
-    vector<const char *> string_list;
+    vector<std::string> string_list;
     read_file(&string_list, argv[1]);
 
     for (int i = 0, len = string_list.size(); i < len; ++i) {
         Minimizer m(16, 20);
-        m.calculate_and_store(i, string_list[i]);
+        vector<char> codes(string_list[i].size());
+        encode_bases(string_list[i].data(), codes.size(), codes.data());
+        m.calculate_and_store(i, codes.data(), codes.size());
+        m.freeze();
 
         const minimizers_t& minimizers = m.get_minimizers();
-        const std::unordered_set<nstring_t>& keys = minimizers.keys();
+        const MinimizerIndex::Keys keys = minimizers.keys();
 
         vector<int> mins;
         for (auto iter = keys.begin(), eend = keys.end(); iter != eend; ++iter) {
             auto list = minimizers.get_list(*iter);
 
             for (auto min1 = list.begin(), end = list.end(); min1 != end; ++min1) {
-                int pos = (*min1).second;
+                int pos = (*min1).pos;
                 mins.push_back(pos);
             }
 
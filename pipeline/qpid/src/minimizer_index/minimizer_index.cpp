@@ -0,0 +1,390 @@
+#include "./minimizer_index.h"
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <future>
+#include "thread_pool/ThreadPool.h"
+
+const unsigned int MinimizerIndex::BUCKETS;
+
+// start of a saved index; the magic number also tells if it was saved with another byte order
+struct saved_index_t {
+    uint32_t magic;
+    uint32_t bucket_shift;
+    uint32_t buckets;
+    uint32_t posting_size;
+    uint32_t keys;
+    uint32_t postings;
+    uint64_t reserved;
+};
+
+const uint32_t SAVED_INDEX_MAGIC = 0x7869646d;
+
+// sections of a saved index start at multiples of 8 bytes
+inline size_t padded(size_t bytes) {
+    return (bytes + 7) & ~(size_t) 7;
+}
+
+MinimizerIndex::MinimizerIndex(int key_bits)
+    : _bucket_shift(std::max(key_bits - BUCKET_BITS, 0)), _frozen(false), _max_occurrences(UINT_MAX), _masked_keys(0), _masked_postings(0),
+    _keys_len(0), _postings_len(0), _keys_data(NULL), _offsets_data(NULL), _postings_data(NULL), _buckets_data(NULL) {
+}
+
+void MinimizerIndex::add(nstring_t key, unsigned int read, unsigned int pos, bool forward) {
+
+    if (_blocks.empty()) _blocks.resize(1);
+    add_to_block(_blocks.size() - 1, key, read, pos, forward);
+}
+
+void MinimizerIndex::set_blocks(unsigned int blocks) {
+    assert(!_frozen);
+
+    if (blocks > _blocks.size()) _blocks.resize(blocks);
+}
+
+void MinimizerIndex::add_to_block(unsigned int block, nstring_t key, unsigned int read, unsigned int pos,
+        bool forward) {
+    assert(!_frozen);
+    assert((key >> _bucket_shift) < BUCKETS);
+
+    triple_t triple;
+    triple.key = key;
+    triple.posting.read = read;
+    triple.posting.pos = pos;
+    triple.posting.forward = forward;
+    _blocks[block].push_back(triple);
+}
+
+// runs task(0), ..., task(n - 1) on the pool and waits for them, or just runs them without one
+template <typename F>
+void run_tasks(ThreadPool* pool, unsigned int n, F task) {
+
+    if (pool == NULL) {
+        for (unsigned int i = 0; i < n; ++i) task(i);
+        return;
+    }
+
+    std::vector<std::future<void>> results;
+    for (unsigned int i = 0; i < n; ++i) {
+        results.push_back(pool->enqueue(task, i));
+    }
+    for (unsigned int i = 0; i < n; ++i) {
+        results[i].get();
+    }
+}
+
+void MinimizerIndex::freeze(ThreadPool* pool) {
+    assert(!_frozen);
+
+    // how many of the bucket's triples come from each block
+    unsigned int blocks = _blocks.size();
+    std::vector<std::vector<unsigned int>> counts(blocks);
+    run_tasks(pool, blocks, [this, &counts] (unsigned int b) {
+        counts[b].assign(BUCKETS, 0);
+        for (const triple_t& triple : _blocks[b]) {
+            ++counts[b][bucket(triple.key)];
+        }
+    });
+
+    // counting sort by bucket: latest blocks go first, so that within a bucket the triples
+    // are in the reverse of the order they were added in; counts become write positions
+    unsigned int n = 0;
+    std::vector<unsigned int> bucket_offsets(BUCKETS + 1);
+    for (unsigned int k = 0; k < BUCKETS; ++k) {
+        bucket_offsets[k] = n;
+        for (int b = blocks - 1; b >= 0; --b) {
+            unsigned int count = counts[b][k];
+            counts[b][k] = n;
+            n += count;
+        }
+    }
+    bucket_offsets[BUCKETS] = n;
+
+    std::vector<triple_t> sorted(n);
+    run_tasks(pool, blocks, [this, &counts, &sorted] (unsigned int b) {
+        std::vector<triple_t>& block = _blocks[b];
+        for (int i = block.size() - 1; i >= 0; --i) {
+            sorted[counts[b][bucket(block[i].key)]++] = block[i];
+        }
+        std::vector<triple_t>().swap(block);
+    });
+    std::vector<std::vector<triple_t>>().swap(_blocks);
+    std::vector<std::vector<unsigned int>>().swap(counts);
+
+    // buckets are split into ranges of about the same size, one task each
+    const unsigned int RANGES = 64;
+    std::vector<unsigned int> ranges(1, 0);
+    for (unsigned int k = 0; k < BUCKETS; ++k) {
+        if (ranges.size() < RANGES && bucket_offsets[k + 1] >= (unsigned long long) n * ranges.size() / RANGES) {
+            ranges.push_back(k + 1);
+        }
+    }
+    if (ranges.back() != BUCKETS) ranges.push_back(BUCKETS);
+
+    // stable sort inside the buckets keeps the latest added first within each key;
+    // _buckets[k] gets the number of keys in bucket k for now
+    _buckets.assign(BUCKETS + 1, 0);
+    run_tasks(pool, ranges.size() - 1, [this, &ranges, &bucket_offsets, &sorted] (unsigned int r) {
+        for (unsigned int k = ranges[r]; k < ranges[r + 1]; ++k) {
+            triple_t* first = sorted.data() + bucket_offsets[k];
+            triple_t* last = sorted.data() + bucket_offsets[k + 1];
+
+            std::stable_sort(first, last, [] (const triple_t& a, const triple_t& b) {
+                return a.key < b.key;
+            });
+            for (triple_t* t = first; t != last; ++t) {
+                if (t == first || t->key != (t - 1)->key) ++_buckets[k];
+            }
+        }
+    });
+
+    // _buckets[k] is the first key whose top bits are at least k
+    unsigned int keys = 0;
+    for (unsigned int k = 0; k <= BUCKETS; ++k) {
+        unsigned int count = _buckets[k];
+        _buckets[k] = keys;
+        keys += count;
+    }
+
+    _keys.resize(keys);
+    _offsets.resize(keys + 1);
+    _postings.resize(n);
+    run_tasks(pool, ranges.size() - 1, [this, &ranges, &bucket_offsets, &sorted] (unsigned int r) {
+        for (unsigned int k = ranges[r]; k < ranges[r + 1]; ++k) {
+            unsigned int key = _buckets[k];
+            for (unsigned int i = bucket_offsets[k]; i < bucket_offsets[k + 1]; ++i) {
+                if (i == bucket_offsets[k] || sorted[i].key != sorted[i - 1].key) {
+                    _keys[key] = sorted[i].key;
+                    _offsets[key++] = i;
+                }
+                _postings[i] = sorted[i].posting;
+            }
+        }
+    });
+    _offsets[keys] = n;
+
+    point_to_vectors();
+    _frozen = true;
+}
+
+void MinimizerIndex::merge(const MinimizerIndex& older) {
+    assert(_frozen && older._frozen);
+    assert(_bucket_shift == older._bucket_shift);
+
+    std::vector<nstring_t> keys;
+    std::vector<unsigned int> offsets;
+    std::vector<posting_t> postings;
+    keys.reserve(_keys_len + older._keys_len);
+    offsets.reserve(_keys_len + older._keys_len + 1);
+    postings.reserve(_postings_len + older._postings_len);
+
+    // keys are sorted in both; postings of a key shared by both go latest first
+    unsigned int i = 0, j = 0;
+    while (i < _keys_len || j < older._keys_len) {
+        bool take_this = j == older._keys_len || (i < _keys_len && _keys_data[i] <= older._keys_data[j]);
+        bool take_older = i == _keys_len || (j < older._keys_len && older._keys_data[j] <= _keys_data[i]);
+
+        keys.push_back(take_this ? _keys_data[i] : older._keys_data[j]);
+        offsets.push_back(postings.size());
+        if (take_this) {
+            postings.insert(postings.end(), _postings_data + _offsets_data[i], _postings_data + _offsets_data[i + 1]);
+            ++i;
+        }
+        if (take_older) {
+            postings.insert(postings.end(), older._postings_data + older._offsets_data[j],
+                    older._postings_data + older._offsets_data[j + 1]);
+            ++j;
+        }
+    }
+    offsets.push_back(postings.size());
+
+    std::vector<unsigned int> buckets(BUCKETS + 1);
+    unsigned int k = 0;
+    for (unsigned int b = 0; b <= BUCKETS; ++b) {
+        while (k < keys.size() && bucket(keys[k]) < b) ++k;
+        buckets[b] = k;
+    }
+
+    _keys.swap(keys);
+    _offsets.swap(offsets);
+    _postings.swap(postings);
+    _buckets.swap(buckets);
+    point_to_vectors();
+}
+
+void MinimizerIndex::point_to_vectors() {
+    _keys_len = _keys.size();
+    _postings_len = _postings.size();
+    _keys_data = _keys.data();
+    _offsets_data = _offsets.data();
+    _postings_data = _postings.data();
+    _buckets_data = _buckets.data();
+}
+
+int MinimizerIndex::find(nstring_t key) const {
+    assert(_frozen);
+
+    // too wide to be one of the keys
+    if ((key >> _bucket_shift) >= BUCKETS) return -1;
+
+    unsigned int k = bucket(key);
+    const nstring_t* first = _keys_data + _buckets_data[k];
+    const nstring_t* last = _keys_data + _buckets_data[k + 1];
+
+    const nstring_t* found = std::lower_bound(first, last, key);
+    if (found == last || *found != key) {
+        return -1;
+    }
+
+    return found - _keys_data;
+}
+
+const MinimizerIndex::List MinimizerIndex::get_list(nstring_t key) const {
+
+    int k = find(key);
+    if (k < 0) {
+        return List(NULL, NULL);
+    }
+
+    const posting_t* first = _postings_data + _offsets_data[k];
+    const posting_t* last = _postings_data + _offsets_data[k + 1];
+
+    if ((unsigned int) (last - first) > _max_occurrences) {
+        return List(last, last, last - first);
+    }
+
+    return List(first, last);
+}
+
+unsigned int MinimizerIndex::count(nstring_t key) const {
+
+    int k = find(key);
+    return k < 0 ? 0 : _offsets_data[k + 1] - _offsets_data[k];
+}
+
+void MinimizerIndex::mask(unsigned int max_occurrences) {
+    assert(_frozen);
+
+    _max_occurrences = max_occurrences;
+    _masked_keys = _masked_postings = 0;
+
+    for (unsigned int k = 0; k < _keys_len; ++k) {
+        unsigned int occurrences = _offsets_data[k + 1] - _offsets_data[k];
+        if (occurrences > max_occurrences) {
+            ++_masked_keys;
+            _masked_postings += occurrences;
+        }
+    }
+}
+
+unsigned int MinimizerIndex::frequency_cap(double fraction) const {
+    assert(_frozen);
+
+    unsigned int klen = _keys_len;
+    unsigned int masked = fraction * klen;
+    if (masked == 0) return UINT_MAX;
+    if (masked >= klen) return 0;
+
+    std::vector<unsigned int> counts(klen);
+    for (unsigned int k = 0; k < klen; ++k) {
+        counts[k] = _offsets_data[k + 1] - _offsets_data[k];
+    }
+
+    // counts[masked] is the highest count that has to stay; keys with the same count stay too
+    std::nth_element(counts.begin(), counts.begin() + masked, counts.end(), std::greater<unsigned int>());
+    return counts[masked];
+}
+
+unsigned int MinimizerIndex::masked_keys() const {
+    return _masked_keys;
+}
+
+unsigned int MinimizerIndex::masked_postings() const {
+    return _masked_postings;
+}
+
+const MinimizerIndex::Keys MinimizerIndex::keys() const {
+    return Keys(_keys_data, _keys_data + _keys_len);
+}
+
+unsigned int MinimizerIndex::size() const {
+    if (_frozen) return _postings_len;
+
+    unsigned int size = 0;
+    for (const std::vector<triple_t>& block : _blocks) {
+        size += block.size();
+    }
+    return size;
+}
+
+bool MinimizerIndex::frozen() const {
+    return _frozen;
+}
+
+size_t MinimizerIndex::saved_size() const {
+    return sizeof(saved_index_t) + padded(_keys_len * sizeof(nstring_t)) + padded((_keys_len + 1) * sizeof(unsigned int))
+        + padded(_postings_len * sizeof(posting_t)) + padded((BUCKETS + 1) * sizeof(unsigned int));
+}
+
+// writes bytes and zeros up to the next multiple of 8
+static bool write_section(FILE* out, const void* data, size_t bytes) {
+    static const char zeros[8] = {0};
+    size_t padding = padded(bytes) - bytes;
+    return fwrite(data, 1, bytes, out) == bytes && fwrite(zeros, 1, padding, out) == padding;
+}
+
+bool MinimizerIndex::save(FILE* out) const {
+    assert(_frozen);
+
+    saved_index_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SAVED_INDEX_MAGIC;
+    header.bucket_shift = _bucket_shift;
+    header.buckets = BUCKETS;
+    header.posting_size = sizeof(posting_t);
+    header.keys = _keys_len;
+    header.postings = _postings_len;
+
+    return write_section(out, &header, sizeof(header))
+        && write_section(out, _keys_data, _keys_len * sizeof(nstring_t))
+        && write_section(out, _offsets_data, (_keys_len + 1) * sizeof(unsigned int))
+        && write_section(out, _postings_data, _postings_len * sizeof(posting_t))
+        && write_section(out, _buckets_data, (BUCKETS + 1) * sizeof(unsigned int));
+}
+
+bool MinimizerIndex::map(const char* data, size_t len) {
+    assert(!_frozen);
+    assert(((uintptr_t) data & 0x7) == 0);
+
+    saved_index_t header;
+    if (len < sizeof(header)) return false;
+    memcpy(&header, data, sizeof(header));
+
+    if (header.magic != SAVED_INDEX_MAGIC || header.bucket_shift != (uint32_t) _bucket_shift ||
+            header.buckets != BUCKETS || header.posting_size != sizeof(posting_t)) {
+        return false;
+    }
+
+    _keys_len = header.keys;
+    _postings_len = header.postings;
+    if (len != saved_size()) {
+        _keys_len = _postings_len = 0;
+        return false;
+    }
+
+    const char* section = data + sizeof(header);
+    _keys_data = (const nstring_t*) section;
+    section += padded(_keys_len * sizeof(nstring_t));
+    _offsets_data = (const unsigned int*) section;
+    section += padded((_keys_len + 1) * sizeof(unsigned int));
+    _postings_data = (const posting_t*) section;
+    section += padded(_postings_len * sizeof(posting_t));
+    _buckets_data = (const unsigned int*) section;
+
+    std::vector<std::vector<triple_t>>().swap(_blocks);
+    _frozen = true;
+    return true;
+}
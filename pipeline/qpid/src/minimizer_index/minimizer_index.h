@@ -0,0 +1,170 @@
+#ifndef MINIMIZER_INDEX_H
+#define MINIMIZER_INDEX_H
+
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <vector>
+#include "../nucleo_buffer/nucleo_buffer.h"
+
+class ThreadPool;
+
+// Index of minimizer occurrences, built in two phases. First all (minimizer, read, pos,
+// strand) occurrences are collected with add, then freeze radix sorts them by minimizer and packs
+// them into sorted keys, offsets into postings and the postings themselves (CSR).
+// Lookups are a small binary search followed by a contiguous scan.
+// Occurrences can be collected in blocks, one per worker, and freeze can sort them
+// on a thread pool; the result is the same as adding them one by one, block by block.
+// A frozen index can be written out with save and used straight from a mapped file with map.
+class MinimizerIndex {
+ public:
+    struct posting_t {
+        unsigned int read;
+        unsigned int pos : 31;
+        // minimizer is the forward k-mer of the read, not its reverse complement
+        unsigned int forward : 1;
+    };
+
+    class List {
+     public:
+         typedef const posting_t* iterator;
+
+         List(const posting_t* first, const posting_t* last, unsigned int masked = 0)
+             : _first(first), _last(last), _masked(masked) {}
+
+         iterator begin() const {
+             return _first;
+         }
+
+         iterator end() const {
+             return _last;
+         }
+
+         unsigned int size() const {
+             return _last - _first;
+         }
+
+         // postings hidden because the key occurs too often (see mask)
+         unsigned int masked() const {
+             return _masked;
+         }
+
+     private:
+         const posting_t* _first;
+         const posting_t* _last;
+         unsigned int _masked;
+    };
+
+    // sorted keys of a frozen index
+    class Keys {
+     public:
+         typedef const nstring_t* iterator;
+
+         Keys(const nstring_t* first, const nstring_t* last) : _first(first), _last(last) {}
+
+         iterator begin() const {
+             return _first;
+         }
+
+         iterator end() const {
+             return _last;
+         }
+
+         unsigned int size() const {
+             return _last - _first;
+         }
+
+         bool operator==(const Keys& other) const {
+             return size() == other.size() && std::equal(_first, _last, other._first);
+         }
+
+     private:
+         const nstring_t* _first;
+         const nstring_t* _last;
+    };
+
+    // keys have at most key_bits bits, the top ones pick the bucket
+    explicit MinimizerIndex(int key_bits = 32);
+
+    void add(nstring_t key, unsigned int read, unsigned int pos, bool forward = true);
+
+    // makes room for blocks, which different threads can then fill with add_to_block;
+    // blocks keep their order, add appends to the last one
+    void set_blocks(unsigned int blocks);
+    void add_to_block(unsigned int block, nstring_t key, unsigned int read, unsigned int pos,
+            bool forward = true);
+
+    void freeze(ThreadPool* pool = NULL);
+
+    // adds the occurrences of an older frozen index to this frozen one, as if they had been
+    // added before all of this one's
+    void merge(const MinimizerIndex& older);
+
+    // occurrences of the key, latest added first
+    const List get_list(nstring_t key) const;
+    const Keys keys() const;
+
+    // number of occurrences of a key
+    unsigned int count(nstring_t key) const;
+
+    // keys occurring more than max_occurrences times answer lookups with an empty list
+    void mask(unsigned int max_occurrences);
+
+    // smallest cap that masks at most the given fraction of keys, the most frequent ones
+    unsigned int frequency_cap(double fraction) const;
+
+    unsigned int masked_keys() const;
+    unsigned int masked_postings() const;
+
+    unsigned int size() const;
+    bool frozen() const;
+
+    // writes the frozen index, false if writing failed; the layout has no pointers, and every
+    // section starts at a multiple of 8 bytes from the start
+    bool save(FILE* out) const;
+    // uses an index written by save from memory it does not own (a mapped file, aligned to
+    // 8 bytes), which has to outlive it; false if the data is not a valid index
+    bool map(const char* data, size_t len);
+    // bytes save writes
+    size_t saved_size() const;
+
+ private:
+    struct triple_t {
+        nstring_t key;
+        posting_t posting;
+    };
+
+    // keys are split into buckets by their top bits, so a lookup only searches one bucket
+    static const int BUCKET_BITS = 16;
+    static const unsigned int BUCKETS = 1u << BUCKET_BITS;
+
+    // position of the key in the keys, or -1
+    int find(nstring_t key) const;
+
+    // points the lookup tables at the vectors, after freeze
+    void point_to_vectors();
+
+    unsigned int bucket(nstring_t key) const {
+        return key >> _bucket_shift;
+    }
+
+    int _bucket_shift;
+    bool _frozen;
+    unsigned int _max_occurrences;
+    unsigned int _masked_keys;
+    unsigned int _masked_postings;
+    std::vector<std::vector<triple_t>> _blocks;
+    std::vector<nstring_t> _keys;
+    std::vector<unsigned int> _offsets;
+    std::vector<posting_t> _postings;
+    std::vector<unsigned int> _buckets;
+
+    // lookup tables, in the vectors above or in mapped memory
+    unsigned int _keys_len;
+    unsigned int _postings_len;
+    const nstring_t* _keys_data;
+    const unsigned int* _offsets_data;
+    const posting_t* _postings_data;
+    const unsigned int* _buckets_data;
+};
+#endif
@@ -0,0 +1,265 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <map>
+#include <future>
+#include <vector>
+#include "minimizer_index.h"
+#include "thread_pool/ThreadPool.h"
+
+typedef std::map<nstring_t, std::vector<MinimizerIndex::posting_t>> naive_index_t;
+
+void fill_index(MinimizerIndex& index, naive_index_t& naive, int size, int keys_num) {
+    for (int i = 0; i < size; ++i) {
+        // keys spread over all the buckets, with a few of them sharing the top bits
+        nstring_t key = (rand() % keys_num) * 2654435761u;
+        if (i % 7 == 0) key = (key & 0xffff0000u) | (rand() % 4);
+
+        MinimizerIndex::posting_t posting;
+        posting.read = i;
+        posting.pos = rand() % 1000;
+        posting.forward = rand() % 2;
+
+        index.add(key, posting.read, posting.pos, posting.forward);
+        naive[key].push_back(posting);
+    }
+}
+
+void test_lookup(int size, int keys_num) {
+    MinimizerIndex index;
+    naive_index_t naive;
+
+    srand(size);
+    fill_index(index, naive, size, keys_num);
+    index.freeze();
+
+    assert(index.frozen());
+    assert(index.size() == (unsigned int) size);
+    assert(index.keys().size() == naive.size());
+
+    unsigned int iterated = 0;
+    for (auto it = naive.begin(); it != naive.end(); ++it) {
+        MinimizerIndex::List list = index.get_list(it->first);
+        assert(list.size() == it->second.size());
+
+        // latest added comes first
+        int expected = it->second.size() - 1;
+        for (auto posting = list.begin(); posting != list.end(); ++posting, --expected) {
+            assert(posting->read == it->second[expected].read);
+            assert(posting->pos == it->second[expected].pos);
+            assert(posting->forward == it->second[expected].forward);
+            ++iterated;
+        }
+    }
+    assert(iterated == (unsigned int) size);
+
+    // keys that were never added
+    for (int i = 0; i < 1000; ++i) {
+        nstring_t key = rand();
+        if (naive.count(key)) continue;
+        assert(index.get_list(key).size() == 0);
+        assert(index.get_list(key).begin() == index.get_list(key).end());
+    }
+}
+
+// blocks filled by different threads and sorted on the pool give the same index
+void test_blocks(int size, int keys_num, int blocks, ThreadPool* pool) {
+    MinimizerIndex index, serial;
+
+    srand(size + blocks);
+    std::vector<std::vector<std::pair<nstring_t, MinimizerIndex::posting_t>>> added(blocks);
+    for (int i = 0; i < size; ++i) {
+        nstring_t key = (rand() % keys_num) * 2654435761u;
+
+        MinimizerIndex::posting_t posting;
+        posting.read = i;
+        posting.pos = rand() % 1000;
+        posting.forward = rand() % 2;
+
+        added[(long long) i * blocks / size].push_back(std::make_pair(key, posting));
+        serial.add(key, posting.read, posting.pos, posting.forward);
+    }
+
+    index.set_blocks(blocks);
+    std::vector<std::future<void>> results;
+    for (int b = 0; b < blocks; ++b) {
+        results.push_back(pool->enqueue([&index, &added, b] () {
+            for (auto& a : added[b]) {
+                index.add_to_block(b, a.first, a.second.read, a.second.pos, a.second.forward);
+            }
+        }));
+    }
+    for (auto& result : results) result.get();
+
+    assert(index.size() == (unsigned int) size);
+    index.freeze(pool);
+    serial.freeze();
+
+    assert(index.keys() == serial.keys());
+    for (nstring_t key : serial.keys()) {
+        MinimizerIndex::List list = index.get_list(key), expected = serial.get_list(key);
+        assert(list.size() == expected.size());
+        for (auto p = list.begin(), e = expected.begin(); p != list.end(); ++p, ++e) {
+            assert(p->read == e->read && p->pos == e->pos && p->forward == e->forward);
+        }
+    }
+}
+
+void test_masking() {
+    MinimizerIndex index;
+
+    // key k occurs k times
+    for (unsigned int k = 1; k <= 100; ++k) {
+        for (unsigned int i = 0; i < k; ++i) {
+            index.add(k << 20, i, i);
+        }
+    }
+    index.freeze();
+
+    assert(index.count(42 << 20) == 42);
+    assert(index.count(1000 << 20) == 0);
+    assert(index.frequency_cap(0) == UINT_MAX);
+    assert(index.frequency_cap(0.1) == 90);
+    assert(index.frequency_cap(1) == 0);
+
+    index.mask(90);
+    assert(index.masked_keys() == 10);
+    assert(index.masked_postings() == 91 + 92 + 93 + 94 + 95 + 96 + 97 + 98 + 99 + 100);
+
+    assert(index.get_list(90 << 20).size() == 90);
+    assert(index.get_list(90 << 20).masked() == 0);
+    assert(index.get_list(91 << 20).size() == 0);
+    assert(index.get_list(91 << 20).masked() == 91);
+    assert(index.get_list(1000 << 20).masked() == 0);
+
+    index.mask(UINT_MAX);
+    assert(index.masked_keys() == 0);
+    assert(index.get_list(100 << 20).size() == 100);
+}
+
+// merged index is the one the occurrences of both would give, the older ones added first
+void test_merge(int size, int keys_num) {
+    MinimizerIndex older, newer, serial;
+
+    // the same occurrences three times: split between the two, then older ones and newer ones
+    for (int pass = 0; pass < 3; ++pass) {
+        srand(size + 2);
+        for (int i = 0; i < size; ++i) {
+            nstring_t key = (rand() % keys_num) * 2654435761u;
+            bool is_new = rand() % 3 == 0;
+            unsigned int pos = rand() % 1000;
+            bool forward = rand() % 2;
+
+            if (pass == 0) {
+                (is_new ? newer : older).add(key, i, pos, forward);
+            } else if (is_new == (pass == 2)) {
+                serial.add(key, i, pos, forward);
+            }
+        }
+    }
+
+    older.freeze();
+    newer.freeze();
+    serial.freeze();
+    newer.merge(older);
+
+    assert(newer.size() == (unsigned int) size);
+    assert(newer.keys() == serial.keys());
+    for (nstring_t key : serial.keys()) {
+        MinimizerIndex::List list = newer.get_list(key), expected = serial.get_list(key);
+        assert(list.size() == expected.size());
+        for (auto p = list.begin(), e = expected.begin(); p != list.end(); ++p, ++e) {
+            assert(p->read == e->read && p->pos == e->pos && p->forward == e->forward);
+        }
+    }
+    assert(newer.get_list(12345).size() == 0);
+}
+
+// an index mapped from what save wrote answers like the original
+void test_save_map(int size, int keys_num) {
+    MinimizerIndex index;
+    naive_index_t naive;
+
+    srand(size + 1);
+    fill_index(index, naive, size, keys_num);
+    index.freeze();
+
+    FILE* file = tmpfile();
+    assert(index.save(file));
+    assert((size_t) ftell(file) == index.saved_size());
+
+    // 8-byte aligned, like a mapped file
+    std::vector<uint64_t> buffer((index.saved_size() + 7) / 8);
+    rewind(file);
+    assert(fread(buffer.data(), 1, index.saved_size(), file) == index.saved_size());
+    fclose(file);
+    const char* data = (const char*) buffer.data();
+
+    MinimizerIndex mapped;
+    assert(mapped.map(data, index.saved_size()));
+    assert(mapped.frozen());
+    assert(mapped.size() == index.size());
+    assert(mapped.keys() == index.keys());
+    for (nstring_t key : index.keys()) {
+        MinimizerIndex::List list = mapped.get_list(key), expected = index.get_list(key);
+        assert(list.size() == expected.size());
+        for (auto p = list.begin(), e = expected.begin(); p != list.end(); ++p, ++e) {
+            assert(p->read == e->read && p->pos == e->pos && p->forward == e->forward);
+        }
+    }
+    assert(mapped.get_list(12345).size() == index.get_list(12345).size());
+
+    unsigned int cap = index.frequency_cap(0.01);
+    assert(mapped.frequency_cap(0.01) == cap);
+    index.mask(cap);
+    mapped.mask(cap);
+    assert(mapped.masked_keys() == index.masked_keys());
+    assert(mapped.masked_postings() == index.masked_postings());
+
+    // truncated, or saved for other keys
+    MinimizerIndex truncated, other(20);
+    assert(!truncated.map(data, index.saved_size() - 8));
+    assert(!other.map(data, index.saved_size()));
+}
+
+int main() {
+
+    printf("empty index test: ");
+    MinimizerIndex empty;
+    empty.freeze();
+    assert(empty.get_list(42).size() == 0);
+    printf("OK\n");
+
+    printf("lookup test: ");
+    test_lookup(1, 1);
+    test_lookup(1000, 10);
+    test_lookup(100000, 20000);
+    printf("OK\n");
+
+    printf("blocks test: ");
+    ThreadPool pool(4);
+    test_blocks(1, 1, 1, &pool);
+    test_blocks(1000, 10, 3, &pool);
+    test_blocks(100000, 20000, 16, &pool);
+    test_blocks(10, 5, 32, &pool);
+    printf("OK\n");
+
+    printf("merge test: ");
+    test_merge(0, 1);
+    test_merge(1000, 10);
+    test_merge(100000, 20000);
+    printf("OK\n");
+
+    printf("save and map test: ");
+    test_save_map(0, 1);
+    test_save_map(1000, 10);
+    test_save_map(100000, 20000);
+    printf("OK\n");
+
+    printf("masking test: ");
+    test_masking();
+    printf("OK\n");
+
+    return 0;
+}
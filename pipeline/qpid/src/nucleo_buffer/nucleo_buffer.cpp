@@ -3,8 +3,9 @@
 #include <cstdio>
 
 NucleoBuffer::NucleoBuffer(int size): size(size) {
-    assert(size > 0 && size <= 16);
+    assert(size > 0 && size <= MAX_NSTRING_LEN);
     buffer = 0;
+    reverse = 0;
     content_mask = 0;
     for (int i = 0; i < size; ++i) {
         content_mask = content_mask << 2;
@@ -12,18 +13,19 @@ NucleoBuffer::NucleoBuffer(int size): size(size) {
     }
 }
 
-inline char NucleoBuffer::get_repr(char ch) {
-    ch = toupper(ch);
-    if (ch == 'A') return 0x0;
-    if (ch == 'C') return 0x1;
-    if (ch == 'G') return 0x2;
-    if (ch == 'T') return 0x3;
-    return 0x0;
+nstring_t NucleoBuffer::write(char ch) {
+    return write_code(nucleo_repr(ch));
 }
 
-nstring_t NucleoBuffer::write(char ch) {
+nstring_t NucleoBuffer::write_code(char repr) {
+
     buffer = buffer << 2;
-    buffer |= get_repr(ch);
+    buffer |= repr;
+
+    // complement goes in at the other end
+    reverse = reverse >> 2;
+    reverse |= (nstring_t) (0x3 - repr) << (2 * (size - 1));
+
     return buffer;
 }
 
@@ -31,6 +33,18 @@ nstring_t NucleoBuffer::get_content() {
     return buffer & content_mask;
 }
 
+nstring_t NucleoBuffer::get_reverse_content() {
+    return reverse;
+}
+
+nstring_t NucleoBuffer::get_canonical_content(bool* forward) {
+    nstring_t content = get_content();
+
+    // palindromes count as forward
+    *forward = content <= reverse;
+    return *forward ? content : reverse;
+}
+
 int NucleoBuffer::get_size() {
     return size;
 }
@@ -1,19 +1,114 @@
+#ifndef NUCLEO_BUFFER_H
+#define NUCLEO_BUFFER_H
+
 #include <ctype.h>
 #include <cstdint>
 
-typedef unsigned int nstring_t;
+// k-mer packed by 2 bits per base, so it holds up to MAX_NSTRING_LEN bases
+typedef uint64_t nstring_t;
+
+const int MAX_NSTRING_LEN = 32;
+
+// anything else than ACGT counts as A
+inline char nucleo_repr(char ch) {
+    ch = toupper(ch);
+    if (ch == 'A') return 0x0;
+    if (ch == 'C') return 0x1;
+    if (ch == 'G') return 0x2;
+    if (ch == 'T') return 0x3;
+    return 0x0;
+}
 
 class NucleoBuffer {
  public:
         explicit NucleoBuffer(int size);
         nstring_t write(char ch);
+        // write for a 2-bit code (see encode_bases)
+        nstring_t write_code(char code);
         nstring_t get_content();
+        // reverse complement of the content
+        nstring_t get_reverse_content();
+        // smaller of the content and its reverse complement, forward tells which one it is
+        nstring_t get_canonical_content(bool* forward);
         int get_size();
  private:
         int size;
         nstring_t buffer;
+        nstring_t reverse;
         nstring_t content_mask;
-        char get_repr(char ch);
 };
 
+// NucleoBuffer of a size known at compile time, so masks and shifts are constants
+template <int K>
+class StaticNucleoBuffer {
+ public:
+        static_assert(K > 0 && K <= MAX_NSTRING_LEN, "k-mer does not fit into nstring_t");
+
+        StaticNucleoBuffer() : buffer(0), reverse(0) {}
+
+        nstring_t write(char ch) {
+            return write_code(nucleo_repr(ch));
+        }
+
+        nstring_t write_code(char code) {
+            nstring_t repr = code;
+            buffer = (buffer << 2) | repr;
+            reverse = (reverse >> 2) | ((0x3 - repr) << (2 * (K - 1)));
+            return buffer;
+        }
+
+        nstring_t get_content() {
+            return buffer & CONTENT_MASK;
+        }
+
+        nstring_t get_reverse_content() {
+            return reverse;
+        }
+
+        nstring_t get_canonical_content(bool* forward) {
+            nstring_t content = get_content();
+            *forward = content <= reverse;
+            return *forward ? content : reverse;
+        }
+
+        int get_size() {
+            return K;
+        }
+
+ private:
+        static const nstring_t CONTENT_MASK = K == MAX_NSTRING_LEN ? ~(nstring_t) 0 : ((nstring_t) 1 << (2 * K)) - 1;
+        nstring_t buffer;
+        nstring_t reverse;
+};
+
+// Rolls over 2-bit codes (see encode_bases) one k-mer at a time; after next(), buff holds
+// the k-mer at pos(). Buffer is a NucleoBuffer or a StaticNucleoBuffer, which sets k.
+template <typename Buffer>
+class KmerIterator {
+ public:
+        KmerIterator(Buffer& buff, const char* codes, int len)
+            : buff(buff), codes(codes), len(len), end(0) {
+            while (end < buff.get_size() - 1 && end < len) {
+                buff.write_code(codes[end++]);
+            }
+        }
+
+        // false when there is no k-mer left
+        bool next() {
+            if (end >= len) return false;
+            buff.write_code(codes[end++]);
+            return true;
+        }
+
+        int pos() {
+            return end - buff.get_size();
+        }
+
+ private:
+        Buffer& buff;
+        const char* codes;
+        int len;
+        int end;
+};
 
+#endif
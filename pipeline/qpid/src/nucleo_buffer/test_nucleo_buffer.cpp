@@ -33,7 +33,8 @@ int main(int argc, char **argv) {
         for (int j = 0, len = buff.get_size(); j < len; ++j) {
             buff.write(string_list[i][j]);
         }
-        printf("%s %04x\n", string_list[i], buff.get_content());
+        printf("%s %08llx %08llx\n", string_list[i],
+            (unsigned long long) buff.get_content(), (unsigned long long) buff.get_reverse_content());
     }
 
     return 0;
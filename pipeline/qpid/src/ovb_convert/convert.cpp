@@ -0,0 +1,107 @@
+#include "./convert.h"
+#include <cstring>
+
+bool is_ovb_file(const char* filename) {
+    FILE* fd = fopen(filename, "rb");
+    if (fd == NULL) return false;
+
+    char magic[4];
+    bool ovb = fread(magic, 1, 4, fd) == 4 && memcmp(magic, "OVB1", 4) == 0;
+    fclose(fd);
+
+    return ovb;
+}
+
+long long read_afg_overlaps(FILE* in, const std::function<void(const OVB::Overlap&)>& callback) {
+    // fields seen in the current record, one bit each
+    const int ALL_FIELDS = 0x1f;
+
+    char line[256];
+    bool in_record = false;
+    int fields = 0;
+    long long overlaps = 0;
+    OVB::Overlap overlap;
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        const char* l = line;
+        while (*l == ' ' || *l == '\t') ++l;
+
+        if (strncmp(l, "{OVL", 4) == 0) {
+            in_record = true;
+            fields = 0;
+        } else if (!in_record) {
+            continue;
+        } else if (sscanf(l, "adj:%c", &overlap.adj) == 1) {
+            fields |= 0x1;
+        } else if (sscanf(l, "rds:%d,%d", &overlap.read_one, &overlap.read_two) == 2) {
+            fields |= 0x2;
+        } else if (sscanf(l, "scr:%d", &overlap.score) == 1) {
+            fields |= 0x4;
+        } else if (sscanf(l, "ahg:%d", &overlap.a_hang) == 1) {
+            fields |= 0x8;
+        } else if (sscanf(l, "bhg:%d", &overlap.b_hang) == 1) {
+            fields |= 0x10;
+        } else if (l[0] == '}') {
+            in_record = false;
+            if (fields != ALL_FIELDS) {
+                fprintf(stderr, "OVL record %lld is missing fields\n", overlaps + 1);
+                return -1;
+            }
+            callback(overlap);
+            ++overlaps;
+        }
+    }
+
+    if (ferror(in)) {
+        fprintf(stderr, "Reading OVL records failed after %lld of them\n", overlaps);
+        return -1;
+    }
+    // a cut input ends inside a record
+    if (in_record) {
+        fprintf(stderr, "OVL record %lld is not closed\n", overlaps + 1);
+        return -1;
+    }
+    return overlaps;
+}
+
+void write_afg_overlap(FILE* out, const OVB::Overlap& overlap) {
+    fprintf(out, "{OVL\nadj:%c\nrds:%d,%d\nscr:%d\nahg:%d\nbhg:%d\n}\n",
+        overlap.adj, overlap.read_one, overlap.read_two, overlap.score, overlap.a_hang, overlap.b_hang);
+}
+
+long long afg_to_ovb(FILE* in, const char* filename, uint32_t reads) {
+    OVB::Writer writer;
+    if (writer.open(filename, reads) != 0) return -1;
+
+    long long written = read_afg_overlaps(in, [&writer] (const OVB::Overlap& overlap) {
+        writer.write(overlap);
+    });
+
+    // a valid header over part of the records would pass for the whole file
+    if (written < 0) {
+        writer.discard();
+        return -1;
+    }
+    if (writer.close() != 0) return -1;
+    return written;
+}
+
+long long ovb_to_afg(const char* filename, FILE* out) {
+    OVB::Reader reader;
+    if (reader.open(filename) != 0) return -1;
+
+    if (!reader.verify()) {
+        fprintf(stderr, "Checksum of %s does not match its header\n", filename);
+        return -1;
+    }
+
+    for (uint64_t i = 0, len = reader.size(); i < len; ++i) {
+        write_afg_overlap(out, reader.get(i));
+    }
+
+    if (fflush(out) != 0 || ferror(out)) {
+        fprintf(stderr, "Writing OVL records failed\n");
+        return -1;
+    }
+    return reader.size();
+}
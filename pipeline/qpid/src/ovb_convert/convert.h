@@ -0,0 +1,32 @@
+#ifndef OVB_CONVERT_H
+#define OVB_CONVERT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include "lib/ovb/ovb.h"
+
+// Conversion between AFG OVL records and the binary .ovb format (see lib/ovb/ovb.h).
+
+// whether the file starts like an .ovb file
+bool is_ovb_file(const char* filename);
+
+// calls the callback for every OVL record of the AFG input (fields in any order); returns
+// the number of overlaps, or -1 if a record is missing fields, the input ends inside a
+// record or it cannot be read
+long long read_afg_overlaps(FILE* in, const std::function<void(const OVB::Overlap&)>& callback);
+
+// writes the overlap as an AFG OVL record, the way qpid does
+void write_afg_overlap(FILE* out, const OVB::Overlap& overlap);
+
+// writes every OVL record of the AFG input (fields in any order) to an .ovb file made
+// for the given number of reads (0 if unknown); returns the number of overlaps, or -1
+// with the .ovb file removed if the input is not valid
+long long afg_to_ovb(FILE* in, const char* filename, uint32_t reads);
+
+// writes the overlaps of an .ovb file as AFG OVL records, the way qpid does; returns
+// the number of overlaps, or -1 if the file is not valid, its checksum does not match or
+// the records cannot be written
+long long ovb_to_afg(const char* filename, FILE* out);
+
+#endif
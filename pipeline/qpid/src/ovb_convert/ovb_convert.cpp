@@ -0,0 +1,66 @@
+#include "./convert.h"
+#include "lib/parsero/parsero.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+unsigned int READS_NUM = 0;
+char *INPUT_FILE = NULL;
+char *OUTPUT_FILE = NULL;
+
+void setup_cmd_interface(int argc, char **argv) {
+
+  parsero::set_header("Converts overlaps between AFG and the binary .ovb format; "
+      "the direction is picked from the input.");
+
+  parsero::add_option("n:", "number of reads the overlaps refer to, stored in the .ovb header",
+      [] (char *option) { READS_NUM = atoi(option); }
+      );
+
+  parsero::add_argument("input",
+      [] (char *filename) { INPUT_FILE = filename; }
+      );
+
+  parsero::add_argument("output",
+      [] (char *filename) { OUTPUT_FILE = filename; }
+      );
+
+  parsero::parse(argc, argv);
+}
+
+int main(int argc, char **argv) {
+
+    setup_cmd_interface(argc, argv);
+
+    if (INPUT_FILE == nullptr || OUTPUT_FILE == nullptr) {
+      parsero::help(argv[0]);
+      exit(1);
+    }
+
+    long long converted;
+    if (is_ovb_file(INPUT_FILE)) {
+      FILE *out = fopen(OUTPUT_FILE, "w");
+      if (out == nullptr) {
+        fprintf(stderr, "Cannot open %s\n", OUTPUT_FILE);
+        exit(1);
+      }
+      converted = ovb_to_afg(INPUT_FILE, out);
+      if (fclose(out) != 0) converted = -1;
+    } else {
+      FILE *in = fopen(INPUT_FILE, "r");
+      if (in == nullptr) {
+        fprintf(stderr, "Cannot open %s\n", INPUT_FILE);
+        exit(1);
+      }
+      converted = afg_to_ovb(in, OUTPUT_FILE, READS_NUM);
+      fclose(in);
+    }
+
+    if (converted < 0) {
+      fprintf(stderr, "Converting %s failed\n", INPUT_FILE);
+      exit(1);
+    }
+
+    fprintf(stderr, "* Converted %lld overlaps\n", converted);
+    return 0;
+}
@@ -0,0 +1,258 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "./convert.h"
+#include "lib/ovb/ovb.h"
+
+// path of a new empty file
+std::string temp_file() {
+    char path[] = "/tmp/test_ovb_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    return path;
+}
+
+std::string contents(const std::string& path) {
+    std::string result;
+    FILE* fd = fopen(path.c_str(), "rb");
+    char chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), fd)) > 0) {
+        result.append(chunk, n);
+    }
+    fclose(fd);
+    return result;
+}
+
+void test_format() {
+    OVB::Overlap overlap;
+    overlap.read_one = 0x01020304;
+    overlap.read_two = 7;
+    overlap.score = 250;
+    overlap.a_hang = -12;
+    overlap.b_hang = 40;
+    overlap.adj = 'I';
+
+    char record[OVB::RECORD_SIZE];
+    OVB::encode_overlap(overlap, record);
+
+    // little-endian, whatever the host is
+    assert(record[0] == 0x04 && record[1] == 0x03 && record[2] == 0x02 && record[3] == 0x01);
+    assert((uint8_t) record[12] == 0xf4 && (uint8_t) record[15] == 0xff);
+    assert(record[20] == 'I' && record[21] == 0 && record[23] == 0);
+
+    OVB::Overlap decoded;
+    OVB::decode_overlap(record, &decoded);
+    assert(decoded.read_one == overlap.read_one && decoded.read_two == overlap.read_two);
+    assert(decoded.score == overlap.score && decoded.a_hang == -12 && decoded.b_hang == 40);
+    assert(decoded.adj == 'I');
+
+    OVB::Header header, decoded_header;
+    header.reads = 1000;
+    header.overlaps = 1ull << 40;
+    header.checksum = 0xdeadbeefcafef00dull;
+
+    char buffer[OVB::HEADER_SIZE];
+    OVB::encode_header(header, buffer);
+    assert(memcmp(buffer, "OVB1", 4) == 0);
+    assert(OVB::decode_header(buffer, &decoded_header));
+    assert(decoded_header.reads == 1000 && decoded_header.overlaps == 1ull << 40);
+    assert(decoded_header.checksum == header.checksum);
+
+    buffer[4] = 2;
+    assert(!OVB::decode_header(buffer, &decoded_header));
+}
+
+// AFG -> .ovb -> AFG gives qpid's AFG back, whatever the order of fields was
+void test_round_trip(int overlaps_num) {
+    std::string afg = temp_file(), ovb = temp_file(), back = temp_file();
+
+    srand(overlaps_num);
+    std::string expected;
+    FILE* out = fopen(afg.c_str(), "w");
+    std::vector<OVB::Overlap> overlaps;
+    for (int i = 0; i < overlaps_num; ++i) {
+        OVB::Overlap o;
+        o.read_one = rand() % 1000;
+        o.read_two = rand() % 1000;
+        o.score = rand() % 10000;
+        o.a_hang = rand() % 200 - 100;
+        o.b_hang = rand() % 200 - 100;
+        o.adj = rand() % 2 ? 'N' : 'I';
+        overlaps.push_back(o);
+
+        char record[256];
+        snprintf(record, sizeof(record), "{OVL\nadj:%c\nrds:%d,%d\nscr:%d\nahg:%d\nbhg:%d\n}\n",
+            o.adj, o.read_one, o.read_two, o.score, o.a_hang, o.b_hang);
+        expected += record;
+
+        // layout writes the fields in another order
+        if (i % 2) {
+            fprintf(out, "{OVL\nrds:%d,%d\nadj:%c\nahg:%d\nbhg:%d\nscr:%d\n}\n",
+                o.read_one, o.read_two, o.adj, o.a_hang, o.b_hang, o.score);
+        } else {
+            fputs(record, out);
+        }
+    }
+    fclose(out);
+
+    FILE* in = fopen(afg.c_str(), "r");
+    assert(afg_to_ovb(in, ovb.c_str(), 1000) == overlaps_num);
+    fclose(in);
+    assert(is_ovb_file(ovb.c_str()));
+    assert(!is_ovb_file(afg.c_str()));
+
+    OVB::Reader reader;
+    assert(reader.open(ovb.c_str()) == 0);
+    assert(reader.header().reads == 1000);
+    assert(reader.size() == (uint64_t) overlaps_num);
+    assert(reader.verify());
+    for (int i = 0; i < overlaps_num; ++i) {
+        OVB::Overlap o = reader.get(i);
+        assert(o.read_one == overlaps[i].read_one && o.read_two == overlaps[i].read_two);
+        assert(o.score == overlaps[i].score && o.adj == overlaps[i].adj);
+        assert(o.a_hang == overlaps[i].a_hang && o.b_hang == overlaps[i].b_hang);
+    }
+    reader.close();
+
+    out = fopen(back.c_str(), "w");
+    assert(ovb_to_afg(ovb.c_str(), out) == overlaps_num);
+    fclose(out);
+    assert(contents(back) == expected);
+
+    unlink(afg.c_str());
+    unlink(ovb.c_str());
+    unlink(back.c_str());
+}
+
+// a changed record fails the checksum, a cut file does not open
+void test_corrupt() {
+    std::string afg = temp_file(), ovb = temp_file();
+
+    FILE* out = fopen(afg.c_str(), "w");
+    fputs("{OVL\nadj:N\nrds:1,2\nscr:100\nahg:5\nbhg:6\n}\n{OVL\nadj:I\nrds:3,4\nscr:90\nahg:-5\nbhg:-6\n}\n", out);
+    fclose(out);
+
+    FILE* in = fopen(afg.c_str(), "r");
+    assert(afg_to_ovb(in, ovb.c_str(), 0) == 2);
+    fclose(in);
+
+    std::string data = contents(ovb);
+    assert(data.size() == (size_t) OVB::HEADER_SIZE + 2 * OVB::RECORD_SIZE);
+
+    FILE* null = fopen("/dev/null", "w");
+    data[OVB::HEADER_SIZE + OVB::RECORD_SIZE + 8] ^= 1;
+    out = fopen(ovb.c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), out);
+    fclose(out);
+    assert(ovb_to_afg(ovb.c_str(), null) == -1);
+
+    out = fopen(ovb.c_str(), "wb");
+    fwrite(data.data(), 1, data.size() - 1, out);
+    fclose(out);
+    OVB::Reader reader;
+    assert(reader.open(ovb.c_str()) == -1);
+
+    // a record without all the fields
+    out = fopen(afg.c_str(), "w");
+    fputs("{OVL\nadj:N\nrds:1,2\nscr:100\n}\n", out);
+    fclose(out);
+    in = fopen(afg.c_str(), "r");
+    assert(afg_to_ovb(in, ovb.c_str(), 0) == -1);
+    fclose(in);
+
+    fclose(null);
+    unlink(afg.c_str());
+    unlink(ovb.c_str());
+}
+
+// an AFG file cut inside its last record, from the end of "{OVL" up to its closing brace,
+// leaves no .ovb file behind
+void test_truncated() {
+    std::string afg = temp_file(), ovb = temp_file();
+    const std::string records =
+        "{OVL\nadj:N\nrds:1,2\nscr:100\nahg:5\nbhg:6\n}\n{OVL\nadj:I\nrds:3,4\nscr:90\nahg:-5\nbhg:-6\n}\n";
+    const size_t second = records.find("{OVL", 1);
+
+    for (size_t len = second + 4; len < records.size() - 2; ++len) {
+        FILE* out = fopen(afg.c_str(), "w");
+        fwrite(records.data(), 1, len, out);
+        fclose(out);
+
+        FILE* in = fopen(afg.c_str(), "r");
+        assert(afg_to_ovb(in, ovb.c_str(), 0) == -1);
+        fclose(in);
+        assert(access(ovb.c_str(), F_OK) != 0);
+    }
+
+    // the whole file still converts
+    FILE* out = fopen(afg.c_str(), "w");
+    fwrite(records.data(), 1, records.size(), out);
+    fclose(out);
+    FILE* in = fopen(afg.c_str(), "r");
+    assert(afg_to_ovb(in, ovb.c_str(), 0) == 2);
+    fclose(in);
+    assert(access(ovb.c_str(), F_OK) == 0);
+
+    unlink(afg.c_str());
+    unlink(ovb.c_str());
+}
+
+// a full device fails the conversion either way, instead of leaving a cut output
+void test_full_device() {
+    std::string afg = temp_file(), ovb = temp_file();
+
+    FILE* out = fopen(afg.c_str(), "w");
+    for (int i = 0; i < 1000; ++i) {
+        fprintf(out, "{OVL\nadj:N\nrds:%d,%d\nscr:100\nahg:5\nbhg:6\n}\n", i, i + 1);
+    }
+    fclose(out);
+
+    FILE* in = fopen(afg.c_str(), "r");
+    assert(afg_to_ovb(in, "/dev/full", 0) == -1);
+    fclose(in);
+
+    in = fopen(afg.c_str(), "r");
+    assert(afg_to_ovb(in, ovb.c_str(), 0) == 1000);
+    fclose(in);
+
+    out = fopen("/dev/full", "w");
+    assert(out != NULL);
+    assert(ovb_to_afg(ovb.c_str(), out) == -1);
+    fclose(out);
+
+    unlink(afg.c_str());
+    unlink(ovb.c_str());
+}
+
+int main() {
+
+    printf("format test: ");
+    test_format();
+    printf("OK\n");
+
+    printf("round trip test: ");
+    test_round_trip(0);
+    test_round_trip(1);
+    test_round_trip(10000);
+    printf("OK\n");
+
+    printf("corrupt file test: ");
+    test_corrupt();
+    printf("OK\n");
+
+    printf("truncated input test: ");
+    test_truncated();
+    printf("OK\n");
+
+    printf("full device test: ");
+    test_full_device();
+    printf("OK\n");
+
+    return 0;
+}
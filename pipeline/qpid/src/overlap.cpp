@@ -2,11 +2,20 @@
 #include "timer/timer.h"
 #include "memory/memory.cpp"
 #include "align/align.h"
+#include "chain/chain.h"
 #include "read.h"
+#include "read_store/read_store.h"
+#include "read_collapser/read_collapser.h"
+#include "overlap_writer/overlap_writer.h"
+#include "parallel_for/parallel_for.h"
+#include "sketch/sketch.h"
+#include "fm_index/fm_index.h"
 #include "lib/amos/reader.cpp"
+#include "lib/ovb/ovb.h"
 #include "lib/parsero/parsero.h"
 
 #include <algorithm>
+#include <atomic>
 #include <mutex>
 #include <vector>
 #include <string>
@@ -16,6 +25,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <cstdio>
+#include <climits>
 using std::vector;
 using std::string;
 using std::pair;
@@ -25,37 +35,104 @@ typedef unsigned int uint;
 
 int THREADS_NUM = sysconf(_SC_NPROCESSORS_ONLN);
 int ALIGNMENT_BAND_RADIUS = 5;
-int OFFSET_WIGGLE = 3;
-int MERGE_RADIUS = 5 * ALIGNMENT_BAND_RADIUS;
+int MINIMIZER_LEN = 16;
+int WINDOW_LEN = 20;
+int MAX_CHAIN_GAP = 500;
+// a single anchor (MINIMIZER_LEN) is enough by default, chaining then only decides the bands
+int MIN_CHAIN_SCORE = -1;
 double MAXIMUM_ERROR_RATE = 0.03;
+// pairs of reads at least this long are aligned only between chained anchors
+int ANCHORED_MIN_READ_LEN = INT_MAX;
+
+// minimizers occurring more often than the cap, or in the top fraction by occurrences, are masked
+unsigned int MINIMIZER_OCCURRENCE_CAP = UINT_MAX;
+double MINIMIZER_MASK_FRACTION = 0.0002;
+
+// seeding with MinHash sketches of this many k-mers (MINIMIZER_LEN long) instead of minimizers,
+// when above 0; pairs whose sketches give a lower Jaccard similarity are not aligned
+int SKETCH_SIZE = 0;
+// 0.02 unless given, and it can only be given with -z
+double MIN_JACCARD = -1;
+
+// when above 0, only pairs one of the reads ranks among the best this many candidates at one
+// of its ends (by chain score) are aligned
+int MAX_CANDIDATES = 0;
+
+// exact overlaps of at least this many bases are found with an FM-index instead of seeding and
+// aligning, when above 0
+int EXACT_MIN_OVERLAP = 0;
+
+// identical reads are collapsed to one while loading, only that one is overlapped, and the
+// others are written as contained in it
+ReadCollapser* collapser = NULL;
+
+// logs every candidate pair to stderr
+bool DEBUG_MODE = false;
 
 char *INPUT_FILE = NULL;
+char *OUTPUT_FILE = NULL;
 FILE *OUTPUT_FD = stdout;
 
+// reads added to the ones of INPUT_FILE: only they are indexed and overlapped (with all the
+// reads), and their overlaps are appended to the output
+char *BATCH_FILE = NULL;
+
+// reads are split into BLOCKS_NUM blocks and a job overlaps reads of BLOCK_ONE with the ones
+// of BLOCK_TWO, holding only these two blocks in memory
+int BLOCKS_NUM = 1;
+int BLOCK_ONE = 0;
+int BLOCK_TWO = 0;
+
+// minimizer index is saved to, or mapped from, these files instead of being calculated
+char *SAVE_INDEX_FILE = NULL;
+char *LOAD_INDEX_FILE = NULL;
+OverlapWriter* writer;
+
+// overlaps go out as .ovb records instead of AFG, see lib/ovb/ovb.h
+bool BINARY_OUTPUT = false;
+// count and checksum of the records, for the header written at the end
+std::atomic<unsigned long long> ovb_overlaps(0);
+std::atomic<unsigned long long> ovb_checksum(0);
+
 ThreadPool* pool;
 
-bool sort_offsets(offset_t a, offset_t b) {
-    if (a.index == b.index) {
-        return a.lo_offset < b.lo_offset;
-    }
-    return a.index < b.index;
-}
+// candidate pairs seen by find_overlaps_from_chains and the ones the prefilter rejected
+std::atomic<int> candidate_pairs(0);
+std::atomic<int> prefilter_rejected(0);
+// pairs whose every band was left early by banded overlap, see overlap_drop_t
+std::atomic<int> rejected_early(0);
+
+// postings left out of find_overlaps because their minimizer is masked
+std::atomic<long long> skipped_postings(0);
+
+// candidate pairs of sketches and the ones below MIN_JACCARD
+std::atomic<long long> sketched_pairs(0);
+std::atomic<long long> dissimilar_pairs(0);
+
+// candidate pairs neither read ranks among its best MAX_CANDIDATES
+std::atomic<long long> unranked_pairs(0);
 
-int read_from_afg(vector<Read>& reads, const char *filename) {
+// reads the reads from first to last (exclusive) in the order of the file
+int read_from_afg(ReadStore& reads, const char *filename, int first = 0, int last = INT_MAX) {
     Timer* timer = new Timer("reading");
     fprintf(stderr, "* Reading from file %s...\n", filename);
 
     vector<AMOS::Read*> tmp_reads;
-    int reads_size = AMOS::get_reads(tmp_reads, filename);
-    for (int i = 0; i < reads_size; ++i) {
-      const auto& r = tmp_reads[i];
-      int r_len = r->clr_hi - r->clr_lo;
+    int reads_size = AMOS::get_reads(tmp_reads, filename, first, last);
 
-      char* cpy = new char[r_len + 1];
-      strncpy(cpy, r->seq + r->clr_lo, r_len);
-      cpy[r_len] = 0; // terminate
+    uint64_t bases = 0;
+    for (int i = 0; i < reads_size; ++i) {
+      bases += tmp_reads[i]->clr_hi - tmp_reads[i]->clr_lo;
+    }
+    reads.reserve(reads.size() + reads_size, reads.bases() + bases);
 
-      reads.push_back(Read(r->iid, cpy));
+    for (int i = 0; i < reads_size; ++i) {
+      const auto& r = tmp_reads[i];
+      if (collapser != NULL) {
+        collapser->add(reads, r->iid, r->seq + r->clr_lo, r->clr_hi - r->clr_lo);
+      } else {
+        reads.add(r->iid, r->seq + r->clr_lo, r->clr_hi - r->clr_lo);
+      }
       delete tmp_reads[i];
     }
 
@@ -65,8 +142,27 @@ int read_from_afg(vector<Read>& reads, const char *filename) {
     return reads_size;
 }
 
+// formats the overlap and appends it to the output buffer of the calling thread
 void output_overlap(const Overlap& overlap) {
-    fprintf(OUTPUT_FD, "{OVL\nadj:%c\nrds:%d,%d\nscr:%d\nahg:%d\nbhg:%d\n}\n",
+    if (BINARY_OUTPUT) {
+      OVB::Overlap ovb;
+      ovb.read_one = overlap.r1.id;
+      ovb.read_two = overlap.r2.id;
+      ovb.score = (int) overlap.score;
+      ovb.a_hang = overlap.a_hang;
+      ovb.b_hang = overlap.b_hang;
+      ovb.adj = overlap.normal_overlap ? 'N' : 'I';
+
+      char record[OVB::RECORD_SIZE];
+      OVB::encode_overlap(ovb, record);
+      ovb_overlaps++;
+      ovb_checksum += OVB::record_checksum(record);
+      writer->write(record, OVB::RECORD_SIZE);
+      return;
+    }
+
+    char record[128];
+    int len = snprintf(record, sizeof(record), "{OVL\nadj:%c\nrds:%d,%d\nscr:%d\nahg:%d\nbhg:%d\n}\n",
         overlap.normal_overlap ? 'N' : 'I',
         overlap.r1.id,
         overlap.r2.id,
@@ -74,156 +170,534 @@ void output_overlap(const Overlap& overlap) {
         overlap.a_hang,
         overlap.b_hang
    );
+    writer->write(record, len);
 }
 
-char base_complement(char base) {
-    if (base == 'A')        return 'T';
-    else if (base == 'C')   return 'G';
-    else if (base == 'G')   return 'C';
-    else                    return 'A';
-}
+// lowest error rate an overlap ending in end could have, wherever in the band it starts
+double lowest_error_rate(int score, const pair<int, int>& end, int d_min, int d_max) {
 
-const Read reversed_complement(const Read& read) {
+    double lowest = 1;
+    for (int d = std::max(d_min, -end.first), dlen = std::min(d_max, end.second); d <= dlen; ++d) {
+      int len = (end.first + end.second - abs(d)) / 2;
+      if (len <= 0) continue;
 
-    int len = strlen(read.sequence);
-    char* result = new char[len + 1];
-    result[len] = 0;
-
-    for (int i = 0; i < len; ++i) {
-        result[i] = base_complement(read.sequence[len - i - 1]);
+      lowest = std::min(lowest, (double) approximate_errors(score, len) / len);
     }
 
-    return Read(read.id, result);
+    return lowest;
 }
 
-void add_offset(vector<offset_t>& offsets, const int& str_index, const int& offset, const int& wiggle) {
+// lowest error rate any overlap inside the band could have, from a lower bound on the
+// edit distance of every end (see banded_edit_distance) and the longest overlap ending there
+double error_rate_bound(const char* a, int alen, const char* b, int blen, int d_min, int d_max) {
 
-    // extend existing offset if it is possible
-    for (int i = 0, len = offsets.size(); i < len; ++i) {
-        if (offsets[i].index != str_index) continue;
+    static thread_local vector<int> last_row, last_col;
+    int width = d_max - d_min + 1;
+    last_row.resize(width);
+    last_col.resize(width);
 
-        // merge it
-        if (offsets[i].lo_offset - wiggle <= offset && offsets[i].hi_offset + wiggle >= offset) {
-            offsets[i].lo_offset = std::min(offsets[i].lo_offset, offset);
-            offsets[i].hi_offset = std::max(offsets[i].hi_offset, offset);
-            return;
-        }
+    banded_edit_distance(a, alen, b, blen, d_min, d_max, &last_row[0], &last_col[0]);
+
+    // the longest overlaps start on the diagonal of the band closest to the main one
+    int shortest_hang = d_min <= 0 && d_max >= 0 ? 0 : std::min(abs(d_min), abs(d_max));
+
+    double lowest = 1;
+    for (int k = 0; k < width; ++k) {
+      int d = d_min + k;
+
+      if (last_row[k] != INT_MAX) {
+        int len = (alen + alen + d - shortest_hang) / 2;
+        if (len > 0) lowest = std::min(lowest, (double) minimal_errors(last_row[k]) / len);
+      }
+
+      if (last_col[k] != INT_MAX) {
+        int len = (blen - d + blen - shortest_hang) / 2;
+        if (len > 0) lowest = std::min(lowest, (double) minimal_errors(last_col[k]) / len);
+      }
     }
 
-    // not merged, add it as standalone
-    offsets.push_back(offset_t(str_index, offset));
+    return lowest;
 }
 
-void merge_offsets(vector<offset_t>& offsets, uint radius) {
+// long reads: every chain of the pair is aligned only in the gaps between its anchors
+// (see anchored_overlap), and the best one wins
+void find_anchored_overlap(const Read &target, const Read &query, const chain_t* chains,
+    int chains_len, const vector<anchor_t>& chained, int anchor_len, bool target_forward_oriented) {
 
-    if (offsets.size() == 0) return;
+    int len_t = target.length;
+    int len_q = query.length;
 
-    // index of current offset
-    uint curr = 0;
-    for (uint i = 1, len = offsets.size(); i < len; ++i) {
-        if (offsets[curr].index == offsets[i].index && offsets[curr].hi_offset + radius >= offsets[i].lo_offset - radius) {
-            // extend offset to the right
-            offsets[curr].hi_offset = std::max(offsets[curr].hi_offset, offsets[i].hi_offset);
-        } else {
-            // finish current offset
-            curr++;
-            if (curr < i) offsets[curr] = offsets[i];
-        }
+    static thread_local vector<pair<int, int>> positions;
+
+    int best_score = NEG_INF;
+    std::pair<int, int> best_start, best_end, start, end;
+    for (int j = 0; j < chains_len; ++j) {
+      const chain_t& chain = chains[j];
+
+      positions.clear();
+      for (int k = chain.first_anchor, klen = k + chain.anchors; k < klen; ++k) {
+        positions.push_back(std::make_pair(chained[k].target_pos, chained[k].query_pos));
+      }
+
+      int score = anchored_overlap(target.codes, len_t, query.codes, len_q,
+          &positions[0], positions.size(), anchor_len, ALIGNMENT_BAND_RADIUS, &start, &end);
+
+      if (score > best_score) {
+        best_score = score;
+        best_start = start;
+        best_end = end;
+      }
     }
 
-    offsets.resize(curr + 1);
+    if (best_score == NEG_INF) return;
+
+    Overlap best_overlap(target, query, best_score, best_start, best_end, target_forward_oriented, true);
+
+    if (best_overlap.error_rate < MAXIMUM_ERROR_RATE) {
+      output_overlap(best_overlap);
+    } else if (DEBUG_MODE) {
+      fprintf(stderr, "Overlap skipped because of error rate (%lf >= %lf [max])\n", best_overlap.error_rate, MAXIMUM_ERROR_RATE);
+    }
 }
 
-void find_overlaps_from_offsets(vector<Read>& reads, int t, const Read &target, vector<offset_t>& offsets,
-    bool target_forward_oriented) {
+// chains are grouped by read, see chain_anchors; target is the read itself or its reverse complement
+void find_overlaps_from_chains(const ReadStore& reads, const Read &target, vector<chain_t>& chains,
+    const vector<anchor_t>& chained, int anchor_len, bool target_forward_oriented) {
+
+    int len_t = target.length;
+
+    // codes of the other read of the pair
+    static thread_local vector<char> query_codes;
 
-    int len_t = strlen(target.sequence);
+    int i = 0, chains_len = chains.size();
+    while (i < chains_len) {
+      int q = chains[i].read;
+      const Read query = reads.get(q, query_codes);
+      int len_q = query.length;
+
+      int first = i;
+      while (i < chains_len && (int) chains[i].read == q) ++i;
+
+      candidate_pairs++;
+      if (std::min(len_t, len_q) >= ANCHORED_MIN_READ_LEN) {
+        find_anchored_overlap(target, query, &chains[first], i - first, chained, anchor_len,
+            target_forward_oriented);
+        continue;
+      }
 
-    int i = 0, offsets_len = offsets.size();
-    while (i < offsets_len) {
-      Overlap best_overlap;
-      std::pair<int, int> start, end;
-      int q = offsets[i].index;
-      int len_q = strlen(reads[q].sequence);
+      // prefilter: skip the pair if none of its bands can have an overlap passing the error rate
+      double bound = 1;
+      for (int j = first; j < i && bound >= MAXIMUM_ERROR_RATE; ++j) {
+        bound = std::min(bound, error_rate_bound(target.codes, len_t, query.codes, len_q,
+              chains[j].lo_diagonal - ALIGNMENT_BAND_RADIUS, chains[j].hi_diagonal + ALIGNMENT_BAND_RADIUS));
+      }
+      if (bound >= MAXIMUM_ERROR_RATE) {
+        prefilter_rejected++;
+        continue;
+      }
 
-      int first_j = i;
-      for (int j = i; j < offsets_len && offsets[j].index == q; ++j, ++i) {
-        offset_t& offset = offsets[j];
-        int score = banded_overlap(
-            target.sequence,
+      // first phase: score pass for every band, the best one wins
+      int best_score = 0, best_j = -1;
+      std::pair<int, int> best_end, end;
+      for (int j = first; j < i; ++j) {
+        chain_t& chain = chains[j];
+        int score = banded_overlap_simd(
+            target.codes,
             len_t,
-            reads[q].sequence,
+            query.codes,
             len_q,
-            offset.lo_offset - ALIGNMENT_BAND_RADIUS,
-            offset.hi_offset + ALIGNMENT_BAND_RADIUS,
-            &start,
-            &end
+            chain.lo_diagonal - ALIGNMENT_BAND_RADIUS,
+            chain.hi_diagonal + ALIGNMENT_BAND_RADIUS,
+            NULL,
+            &end,
+            MAXIMUM_ERROR_RATE
         );
 
-        Overlap curr_overlap(reads[t], reads[q], score, start, end, target_forward_oriented, true);
+        // a band left early scores below any other one
+        if (best_j == -1 || score > best_score) {
+          best_score = score;
+          best_end = end;
+          best_j = j;
+        }
+      }
 
-        if (j == first_j || score > best_overlap.score) {
-          best_overlap = curr_overlap;
+      if (best_score == REJECTED_EARLY) {
+        rejected_early++;
+        continue;
+      }
 
-          fprintf(stderr, "Overlap lengths (%d %d) of (%d %d)\n",
-    	    end.first - start.first,
-	    end.second - start.second,
-	    len_t, len_q 
-	  );
-        }
+      int d_min = chains[best_j].lo_diagonal - ALIGNMENT_BAND_RADIUS;
+      int d_max = chains[best_j].hi_diagonal + ALIGNMENT_BAND_RADIUS;
+
+      double error_rate = lowest_error_rate(best_score, best_end, d_min, d_max);
+      if (error_rate >= MAXIMUM_ERROR_RATE) {
+        if (DEBUG_MODE) fprintf(stderr, "Overlap skipped because of error rate (%lf >= %lf [max])\n", error_rate, MAXIMUM_ERROR_RATE);
+        continue;
       }
 
+      // second phase: reverse pass from the end finds where the overlap starts
+      std::pair<int, int> start;
+      banded_overlap_start(target.codes, len_t, query.codes, len_q, d_min, d_max, best_score, best_end, &start);
+
+      Overlap best_overlap(target, query, best_score, start, best_end, target_forward_oriented, true);
+
+      if (DEBUG_MODE) {
+        fprintf(stderr, "Overlap lengths (%d %d) of (%d %d)\n",
+            best_end.first - start.first,
+            best_end.second - start.second,
+            len_t, len_q
+        );
+      }
 
       if (best_overlap.error_rate < MAXIMUM_ERROR_RATE) {
         output_overlap(best_overlap);
-      } else {
-	fprintf(stderr, "Overlap skipped because of error rate (%lf >= %lf [max])\n", best_overlap.error_rate, MAXIMUM_ERROR_RATE);		
+      } else if (DEBUG_MODE) {
+        fprintf(stderr, "Overlap skipped because of error rate (%lf >= %lf [max])\n", best_overlap.error_rate, MAXIMUM_ERROR_RATE);
       }
     }
 }
 
-void find_overlaps(vector<Read>& reads, Minimizer *minimizer, int wiggle, int merge_radius, bool forward_overlaps = true) {
+// seeds that can estimate how similar a pair is; minimizers cannot, they propose every pair
+// sharing one of them
+inline const Sketch* as_sketch(const Minimizer*) {
+    return NULL;
+}
 
-    const minimizers_t& minimizers = minimizer->get_minimizers();
+inline const Sketch* as_sketch(const Sketch* sketch) {
+    return sketch;
+}
 
-    vector<std::future<void>> results;
-    for (int t = 0, tlen = reads.size(); t < tlen; ++t) {
+// an anchor of sketches is a hash both reads have, so every read with one is a candidate;
+// anchors of candidates whose sketches give a Jaccard similarity below MIN_JACCARD are dropped
+void drop_dissimilar(const Sketch* sketch, const vector<minimizer_t>& target_sketch,
+    vector<anchor_t>& forward_anchors, vector<anchor_t>& reverse_anchors, bool counted) {
+
+    // of every read: 0 if it is no candidate, 1 if it is similar enough, 2 if not
+    static thread_local vector<char> similarity;
+    static thread_local vector<unsigned int> candidates;
+    static thread_local vector<nstring_t> target_hashes;
+    candidates.clear();
+
+    // the sketch is in order of hash
+    target_hashes.clear();
+    for (const minimizer_t& m : target_sketch) target_hashes.push_back(m.str);
+
+    int dropped = 0;
+    for (auto anchors : { &forward_anchors, &reverse_anchors }) {
+      for (const anchor_t& anchor : *anchors) {
+        if (anchor.read >= similarity.size()) similarity.resize(anchor.read + 1, 0);
+        if (similarity[anchor.read] != 0) continue;
+
+        candidates.push_back(anchor.read);
+        bool dissimilar = sketch->jaccard(target_hashes, sketch->sketch_of(anchor.read)) < MIN_JACCARD;
+        similarity[anchor.read] = dissimilar ? 2 : 1;
+        if (dissimilar) ++dropped;
+      }
+    }
 
-        results.push_back(pool->enqueue([&reads, forward_overlaps, wiggle, merge_radius, &minimizer, &minimizers, t]() {
+    if (counted) {
+      sketched_pairs += candidates.size();
+      dissimilar_pairs += dropped;
+    }
 
-            const Read &target = forward_overlaps ? reads[t] : reversed_complement(reads[t]);
-            vector<minimizer_t> curr_minimizers;
-            vector<offset_t> curr_offsets;
+    if (dropped > 0) {
+      auto dissimilar = [] (const anchor_t& anchor) {
+        return similarity[anchor.read] == 2;
+      };
+      forward_anchors.erase(std::remove_if(forward_anchors.begin(), forward_anchors.end(), dissimilar),
+          forward_anchors.end());
+      reverse_anchors.erase(std::remove_if(reverse_anchors.begin(), reverse_anchors.end(), dissimilar),
+          reverse_anchors.end());
+    }
 
-            minimizer->calculate_and_get(curr_minimizers, target.sequence);
+    for (unsigned int read : candidates) similarity[read] = 0;
+}
 
-            for (uint m = 0, mlen = curr_minimizers.size(); m < mlen; ++m) {
-                auto list = minimizers.get_list(curr_minimizers[m].str);
+// chains of a read with its candidates, grouped by candidate (see chain_anchors), for the read
+// as it is and for its reverse complement
+struct candidates_t {
+    vector<chain_t> forward_chains, reverse_chains;
+    vector<anchor_t> forward_chained, reverse_chained;
+};
 
-                for (auto kp = list.begin(); kp != list.end(); ++kp) {
-                    int k = (*kp).first;
-                    if (t >= k) continue;
+// Chains anchors of read t with the reads after it and with all the reads before first_new, or
+// with every other read when every_pair is set. Only the pairs find_overlaps_of aligns are
+// counted in the stats. Seeds is a Minimizer or a Sketch.
+template <typename Seeds>
+void chain_candidates(Seeds *minimizer, const Read& target, int t, int first_new, bool every_pair,
+    candidates_t& candidates) {
 
-                    add_offset(curr_offsets, k, (*kp).second - curr_minimizers[m].pos, wiggle);
-                }
+    const minimizers_t& minimizers = minimizer->get_minimizers();
+    const int minimizer_len = minimizer->get_minimizer_len();
+
+    // reused by every read this thread works on
+    static thread_local vector<anchor_t> forward_anchors, reverse_anchors;
+    static thread_local vector<minimizer_t> curr_minimizers;
+    forward_anchors.clear();
+    reverse_anchors.clear();
+    curr_minimizers.clear();
+
+    int len_t = target.length;
+
+    minimizer->calculate_and_get(curr_minimizers, target.codes, len_t);
+
+    for (uint m = 0, mlen = curr_minimizers.size(); m < mlen; ++m) {
+        const minimizer_t& curr = curr_minimizers[m];
+        auto list = minimizers.get_list(curr.str);
+        if (list.masked() && !every_pair) skipped_postings += list.masked();
+
+        for (auto kp = list.begin(); kp != list.end(); ++kp) {
+            int k = kp->read;
+            if (every_pair ? k == t : t >= k && k >= first_new) continue;
+
+            // same strand in both reads, or the other read matches the reversed complement
+            anchor_t anchor;
+            anchor.read = k;
+            anchor.query_pos = kp->pos;
+            if (kp->forward == curr.forward) {
+                anchor.target_pos = curr.pos;
+                forward_anchors.push_back(anchor);
+            } else {
+                anchor.target_pos = len_t - curr.pos - minimizer_len;
+                reverse_anchors.push_back(anchor);
             }
+        }
+    }
 
-            std::sort(curr_offsets.begin(), curr_offsets.end(), sort_offsets);
-            merge_offsets(curr_offsets, merge_radius);
+    const Sketch* sketch = as_sketch(minimizer);
+    if (sketch != NULL) drop_dissimilar(sketch, curr_minimizers, forward_anchors, reverse_anchors, !every_pair);
 
-            find_overlaps_from_offsets(reads, t, target, curr_offsets, forward_overlaps);
+    candidates.forward_chains.clear();
+    candidates.forward_chained.clear();
+    chain_anchors(forward_anchors, minimizer_len, MAX_CHAIN_GAP, MIN_CHAIN_SCORE,
+        candidates.forward_chains, &candidates.forward_chained);
 
-            // delete reversed complement from memory
-            if (!forward_overlaps) {
-              delete[] target.sequence;
-            }
-        }));
+    candidates.reverse_chains.clear();
+    candidates.reverse_chained.clear();
+    chain_anchors(reverse_anchors, minimizer_len, MAX_CHAIN_GAP, MIN_CHAIN_SCORE,
+        candidates.reverse_chains, &candidates.reverse_chained);
+}
+
+// score of a candidate, its best chain's
+struct ranked_t {
+    int score;
+    uint read;
+};
+
+// Best MAX_CANDIDATES candidates of read t among all the other reads, at each of its ends, sorted
+// by read. A candidate goes to the end of t its middle lies closer to, on the diagonal of its best
+// chain; contained and containing reads too.
+template <typename Seeds>
+void rank_candidates_of(const ReadStore& reads, Seeds *minimizer, int t, vector<uint>& best) {
+
+    static thread_local candidates_t candidates;
+    static thread_local vector<char> target_codes;
+    static thread_local vector<ranked_t> ends[2];
+
+    const Read target = reads.get(t, target_codes);
+    int len_t = target.length;
+
+    chain_candidates(minimizer, target, t, 0, true, candidates);
+
+    ends[0].clear();
+    ends[1].clear();
+    for (int forward = 1; forward >= 0; --forward) {
+      const vector<chain_t>& chains = forward ? candidates.forward_chains : candidates.reverse_chains;
+
+      // first chain of a read is its best one
+      for (int i = 0, chains_len = chains.size(); i < chains_len; ++i) {
+        if (i > 0 && chains[i].read == chains[i - 1].read) continue;
+
+        // the other read starts at -diagonal of the target, or of its reverse complement
+        int diagonal = (chains[i].lo_diagonal + chains[i].hi_diagonal) / 2;
+        bool left = (int) reads.length(chains[i].read) - 2 * diagonal < len_t;
+        ends[left == (forward == 1) ? 0 : 1].push_back({ chains[i].score, chains[i].read });
+      }
     }
 
-    // wait for the results
-    for (int i = 0, len = results.size(); i < len; ++i) {
-        results[i].get();
+    best.clear();
+    for (vector<ranked_t>& end : ends) {
+      uint kept = std::min(end.size(), (size_t) MAX_CANDIDATES);
+      std::partial_sort(end.begin(), end.begin() + kept, end.end(), [] (const ranked_t& a, const ranked_t& b) {
+          return a.score != b.score ? a.score > b.score : a.read < b.read;
+      });
+      for (uint i = 0; i < kept; ++i) best.push_back(end[i].read);
     }
+
+    std::sort(best.begin(), best.end());
+    best.erase(std::unique(best.begin(), best.end()), best.end());
+}
+
+// chains of the pairs neither read ranks among its best candidates are dropped
+void drop_unranked(const vector<vector<uint>>& best, uint t, vector<chain_t>& chains) {
+
+    int kept = 0, chains_len = chains.size();
+    bool ranked = false;
+    for (int i = 0; i < chains_len; ++i) {
+      uint k = chains[i].read;
+      if (i == 0 || k != chains[i - 1].read) {
+        ranked = std::binary_search(best[t].begin(), best[t].end(), k) ||
+            std::binary_search(best[k].begin(), best[k].end(), t);
+        if (!ranked) unranked_pairs++;
+      }
+      if (ranked) chains[kept++] = chains[i];
+    }
+    chains.resize(kept);
+}
+
+// overlaps of read t with the reads after it, and with all the reads before first_new; only
+// pairs ranked in best are aligned, if given
+template <typename Seeds>
+void find_overlaps_of(const ReadStore& reads, Seeds *minimizer, int t, int first_new,
+    const vector<vector<uint>>* best) {
+
+    const int minimizer_len = minimizer->get_minimizer_len();
+
+    // reused by every read this thread works on
+    static thread_local candidates_t candidates;
+    static thread_local vector<char> target_codes;
+
+    const Read target = reads.get(t, target_codes);
+
+    chain_candidates(minimizer, target, t, first_new, false, candidates);
+    if (best != NULL) {
+      drop_unranked(*best, t, candidates.forward_chains);
+      drop_unranked(*best, t, candidates.reverse_chains);
+    }
+
+    find_overlaps_from_chains(reads, target, candidates.forward_chains, candidates.forward_chained,
+        minimizer_len, true);
+    if (candidates.reverse_chains.empty()) return;
+
+    // the target is done with, so its buffer takes the reverse complement
+    find_overlaps_from_chains(reads, reads.get_reverse_complement(t, target_codes), candidates.reverse_chains,
+        candidates.reverse_chained, minimizer_len, false);
+}
+
+// prints how long each thread was busy, and how uneven the load was
+void report_busy_time(const vector<worker_stats_t>& stats) {
+
+    double max_busy = 0, total_busy = 0;
+    for (int w = 0, wlen = stats.size(); w < wlen; ++w) {
+      fprintf(stderr, "* Thread %d busy for %.2lfs (%u reads in %u chunks)\n",
+          w, stats[w].busy_seconds, stats[w].items, stats[w].chunks);
+      max_busy = std::max(max_busy, stats[w].busy_seconds);
+      total_busy += stats[w].busy_seconds;
+    }
+
+    double mean_busy = total_busy / stats.size();
+    fprintf(stderr, "* Load imbalance (max / mean busy time): %.2lf\n", mean_busy > 0 ? max_busy / mean_busy : 1.);
+}
+
+// overlaps of the reads from first_new on, with each other and with the reads before them
+template <typename Seeds>
+void find_overlaps(const ReadStore& reads, Seeds *minimizer, uint first_new) {
+
+    // longest reads first, so that no long read is left for the end of the run
+    vector<uint> order(reads.size() - first_new);
+    for (uint i = 0; i < order.size(); ++i) order[i] = first_new + i;
+    std::stable_sort(order.begin(), order.end(), [&reads] (uint a, uint b) {
+        return reads.length(a) > reads.length(b);
+    });
+
+    // every read ranks its candidates before any pair is aligned, a pair needs only one of them.
+    // Reads before a batch (-u) rank theirs as well, the merged index holds all the reads; of a
+    // block pair (-p) only the looked up block can, the other one is all the index holds.
+    vector<vector<uint>> best;
+    if (MAX_CANDIDATES > 0) {
+      uint first_ranked = BLOCK_ONE != BLOCK_TWO ? first_new : 0;
+      best.resize(reads.size());
+      Timer rtimer("ranking candidates");
+      parallel_for(pool, THREADS_NUM, reads.size() - first_ranked, [&reads, &minimizer, &best, first_ranked] (uint begin, uint end) {
+          for (uint t = first_ranked + begin; t < first_ranked + end; ++t) {
+              rank_candidates_of(reads, minimizer, t, best[t]);
+          }
+      });
+      rtimer.end();
+    }
+
+    const vector<vector<uint>>* ranked = MAX_CANDIDATES > 0 ? &best : NULL;
+    auto stats = parallel_for(pool, THREADS_NUM, order.size(), [&reads, &minimizer, &order, first_new, ranked] (uint begin, uint end) {
+        for (uint i = begin; i < end; ++i) {
+            find_overlaps_of(reads, minimizer, order[i], first_new, ranked);
+        }
+    });
+
+    report_busy_time(stats);
+}
+
+// every collapsed read, as contained in its representative with no hangs; layout removes
+// contained reads and counts them as coverage of the one containing them
+void output_duplicates(const ReadStore& reads) {
+
+    for (const ReadCollapser::duplicate_t& duplicate : collapser->duplicates()) {
+      int len = reads.length(duplicate.representative);
+      Read r1(duplicate.id, NULL, len);
+      Read r2(reads.id(duplicate.representative), NULL, len);
+      output_overlap(Overlap(r1, r2, len * MATCH_SCORE, { 0, 0 }, { len, len }, duplicate.forward, true));
+    }
+}
+
+// irreducible exact overlaps of read x, as the read and as its reverse complement; every overlap
+// is found from both of its reads, so only one of them outputs it
+void find_exact_overlaps_of(const ReadStore& reads, const FMIndex* fm, uint x) {
+
+    static thread_local vector<char> codes;
+    static thread_local vector<FMIndex::match_t> matches;
+
+    for (int forward = 1; forward >= 0; --forward) {
+      const Read query = forward ? reads.get(x, codes) : reads.get_reverse_complement(x, codes);
+      matches.clear();
+      fm->overlaps(query.codes, query.length, EXACT_MIN_OVERLAP, matches);
+
+      for (const FMIndex::match_t& match : matches) {
+        uint y = match.string / 2;
+        bool target_forward = match.string % 2 == 0;
+
+        // suffix of reverse complements of both is the suffix of y matching the prefix of x
+        if (y == x || (!forward && !target_forward)) continue;
+        if ((!forward || !target_forward) && x > y) continue;
+
+        int len = match.length;
+        int len_x = query.length;
+        int len_y = reads.length(y);
+        Read r1(reads.id(x), NULL, len_x);
+        Read r2(reads.id(y), NULL, len_y);
+
+        // coordinates are for x (or its reverse complement) and y as it is
+        if (forward && target_forward) {
+          output_overlap(Overlap(r1, r2, len * MATCH_SCORE, { len_x - len, 0 }, { len_x, len }, true, true));
+        } else if (forward) {
+          output_overlap(Overlap(r1, r2, len * MATCH_SCORE, { 0, len_y - len }, { len, len_y }, false, true));
+        } else {
+          output_overlap(Overlap(r1, r2, len * MATCH_SCORE, { len_x - len, 0 }, { len_x, len }, false, true));
+        }
+      }
+    }
+}
+
+// exact overlaps of all the reads, on the worker threads
+void find_exact_overlaps(const ReadStore& reads, const FMIndex* fm) {
+
+    auto stats = parallel_for(pool, THREADS_NUM, reads.size(), [&reads, fm] (uint begin, uint end) {
+        for (uint x = begin; x < end; ++x) {
+            find_exact_overlaps_of(reads, fm, x);
+        }
+    });
+
+    report_busy_time(stats);
+}
+
+// prints how many candidate pairs the prefilter and banded overlap rejected since the last report
+void report_prefilter() {
+
+    int pairs = candidate_pairs.exchange(0);
+    int rejected = prefilter_rejected.exchange(0);
+    int early = rejected_early.exchange(0);
+
+    fprintf(stderr, "* Prefilter rejected %d of %d candidate pairs (%.2lf%%)\n",
+        rejected, pairs, pairs > 0 ? 100. * rejected / pairs : 0.);
+    fprintf(stderr, "* Banded overlap gave up early on %d of %d pairs past the prefilter\n", early, pairs - rejected);
 }
 
 void setup_cmd_interface(int argc, char **argv) {
@@ -239,20 +713,88 @@ void setup_cmd_interface(int argc, char **argv) {
       [] (char *option) { ALIGNMENT_BAND_RADIUS = atoi(option); }
       );
 
-  parsero::add_option("w:", "offset wiggle",
-      [] (char *option) { OFFSET_WIGGLE = atoi(option); }
+  parsero::add_option("k:", "minimizer length, at most 32",
+      [] (char *option) { MINIMIZER_LEN = atoi(option); }
+      );
+
+  parsero::add_option("w:", "window length, minimizer is the smallest k-mer in each window",
+      [] (char *option) { WINDOW_LEN = atoi(option); }
       );
 
-  parsero::add_option("r:", "merge radius",
-      [] (char *option) { MERGE_RADIUS = atoi(option); }
+  parsero::add_option("g:", "maximum diagonal gap between chained minimizer hits",
+      [] (char *option) { MAX_CHAIN_GAP = atoi(option); }
+      );
+
+  parsero::add_option("s:", "minimum chain score of a candidate pair",
+      [] (char *option) { MIN_CHAIN_SCORE = atoi(option); }
       );
 
   parsero::add_option("e:", "maximum error rate",
       [] (char *option) { sscanf(option, "%lf", &MAXIMUM_ERROR_RATE); }
       );
 
+  parsero::add_option("l:", "align only between minimizer hits when both reads are at least this long",
+      [] (char *option) { ANCHORED_MIN_READ_LEN = atoi(option); }
+      );
+
+  parsero::add_option("m:", "mask minimizers occurring more than this many times",
+      [] (char *option) { MINIMIZER_OCCURRENCE_CAP = atoi(option); }
+      );
+
+  parsero::add_option("f:", "fraction of the most frequent minimizers to mask",
+      [] (char *option) { sscanf(option, "%lf", &MINIMIZER_MASK_FRACTION); }
+      );
+
   parsero::add_option("o:", "output file; if omitted, goes to stdout",
-      [] (char *filename) { OUTPUT_FD = fopen(filename, "w"); }
+      [] (char *filename) { OUTPUT_FILE = filename; }
+      );
+
+  parsero::add_option("u:", "reads to add to reads.afg: only their overlaps are calculated and appended to the output",
+      [] (char *filename) { BATCH_FILE = filename; }
+      );
+
+  parsero::add_option("z:", "seed with MinHash sketches of this many k-mers per read instead of minimizers",
+      [] (char *option) { SKETCH_SIZE = atoi(option) > 0 ? atoi(option) : -1; }
+      );
+
+  parsero::add_option("r:", "minimum Jaccard similarity of a pair estimated from sketches (-z)",
+      [] (char *option) { sscanf(option, "%lf", &MIN_JACCARD); MIN_JACCARD = std::max(MIN_JACCARD, 0.); }
+      );
+
+  parsero::add_option("n:", "align only pairs in which a read is among the best this many candidates of the other one at one of its ends",
+      [] (char *option) { MAX_CANDIDATES = atoi(option); }
+      );
+
+  parsero::add_option("y:", "find exact overlaps of at least this many bases with an FM-index, without aligning",
+      [] (char *option) { EXACT_MIN_OVERLAP = atoi(option); }
+      );
+
+  parsero::add_option("c", "collapse identical reads, in either orientation, and overlap only one of them",
+      [] (char *) { collapser = new ReadCollapser(); }
+      );
+
+  parsero::add_option("p:", "number of blocks the reads are split into, for jobs of block pairs (-j)",
+      [] (char *option) { BLOCKS_NUM = atoi(option); }
+      );
+
+  parsero::add_option("j:", "block pair i,j of this job; only its reads are loaded",
+      [] (char *option) { sscanf(option, "%d,%d", &BLOCK_ONE, &BLOCK_TWO); }
+      );
+
+  parsero::add_option("x:", "save the minimizer index to a file",
+      [] (char *filename) { SAVE_INDEX_FILE = filename; }
+      );
+
+  parsero::add_option("i:", "load the minimizer index from a file saved with -x, for the same reads, -k and -w",
+      [] (char *filename) { LOAD_INDEX_FILE = filename; }
+      );
+
+  parsero::add_option("b", "write overlaps in binary .ovb format, needs an output file",
+      [] (char *) { BINARY_OUTPUT = true; }
+      );
+
+  parsero::add_option("d", "debug mode, logs every candidate pair to stderr",
+      [] (char *) { DEBUG_MODE = true; }
       );
 
   parsero::add_argument("reads.afg",
@@ -262,6 +804,106 @@ void setup_cmd_interface(int argc, char **argv) {
   parsero::parse(argc, argv);
 }
 
+// Opens OUTPUT_FILE; overlaps of a batch are appended to it. Records of an .ovb file go after
+// its header, which comes back for the overlaps and checksum to be added to at the end.
+void open_output(OVB::Header* header) {
+
+    if (OUTPUT_FILE == NULL) return;
+
+    bool append = BATCH_FILE != NULL;
+    if (!BINARY_OUTPUT) {
+      OUTPUT_FD = fopen(OUTPUT_FILE, append ? "a" : "w");
+    } else {
+      OUTPUT_FD = append ? fopen(OUTPUT_FILE, "r+b") : NULL;
+      if (OUTPUT_FD == NULL) OUTPUT_FD = fopen(OUTPUT_FILE, "w+b");
+    }
+
+    if (OUTPUT_FD == NULL) {
+      fprintf(stderr, "Output file %s cannot be opened.\n", OUTPUT_FILE);
+      exit(1);
+    }
+    if (!BINARY_OUTPUT) return;
+
+    int fd = fileno(OUTPUT_FD);
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size == 0) {
+      // placeholder until the count and checksum are known, records go after it
+      OVB::write_header(fd, *header);
+      lseek(fd, OVB::HEADER_SIZE, SEEK_SET);
+      return;
+    }
+
+    char buffer[OVB::HEADER_SIZE];
+    if (pread(fd, buffer, OVB::HEADER_SIZE, 0) != OVB::HEADER_SIZE || !OVB::decode_header(buffer, header) ||
+        size != (off_t) (OVB::HEADER_SIZE + header->overlaps * OVB::RECORD_SIZE)) {
+      fprintf(stderr, "Output file %s is not a valid .ovb file to append to.\n", OUTPUT_FILE);
+      exit(1);
+    }
+}
+
+// Minimizers of the reads: loaded (-i) or calculated, with the ones of the batch (-u) merged in
+// and saved (-x) if asked to. first_new is where the batch starts.
+Minimizer* build_minimizers(ReadStore& reads, unsigned int* first_new) {
+
+    // create a bank of all minimizers so finding appropriate read pairs could be efficient.
+    Minimizer *m = new Minimizer(MINIMIZER_LEN, WINDOW_LEN);
+    fprintf(stderr, "* Minimizer length %d, window length %d (%s kernel)\n", MINIMIZER_LEN, WINDOW_LEN,
+        m->is_specialized() ? "specialized" : "generic");
+    if (LOAD_INDEX_FILE != NULL) {
+      Timer ltimer("loading minimizers");
+      if (m->load(LOAD_INDEX_FILE, reads.size(), reads.bases()) != 0) {
+        fprintf(stderr, "Index %s cannot be loaded, or it was saved for other reads, minimizer or window length.\n",
+            LOAD_INDEX_FILE);
+        exit(1);
+      }
+      ltimer.end();
+      fprintf(stderr, "* Loaded minimizer index from %s\n", LOAD_INDEX_FILE);
+    } else {
+      Timer mtimer("calculating minimizers");
+      m->calculate_and_store(reads, pool, 0);
+      m->freeze(pool);
+      mtimer.end();
+    }
+
+    // reads of the batch go after the ones the index was built for. Only the batch is
+    // indexed, its index then takes in the one of the other reads.
+    *first_new = 0;
+    if (BATCH_FILE != NULL) {
+      *first_new = reads.size();
+      int reads_size = read_from_afg(reads, BATCH_FILE);
+      fprintf(stderr, "* Read %d strings of the batch...\n", reads_size);
+
+      Timer btimer("calculating minimizers of the batch");
+      Minimizer *batch = new Minimizer(MINIMIZER_LEN, WINDOW_LEN);
+      batch->calculate_and_store(reads, pool, *first_new);
+      batch->freeze(pool);
+      batch->merge(*m);
+      delete m;
+      m = batch;
+      btimer.end();
+    }
+
+    if (SAVE_INDEX_FILE != NULL) {
+      if (m->save(SAVE_INDEX_FILE, reads.size(), reads.bases()) != 0) {
+        fprintf(stderr, "Index cannot be saved to %s.\n", SAVE_INDEX_FILE);
+        exit(1);
+      }
+      fprintf(stderr, "* Saved minimizer index to %s\n", SAVE_INDEX_FILE);
+    }
+
+    return m;
+}
+
+// the stricter of the two caps wins
+template <typename Seeds>
+void mask_frequent(Seeds* seeds) {
+
+    const MinimizerIndex& index = seeds->get_minimizers();
+    seeds->mask(std::min(MINIMIZER_OCCURRENCE_CAP, index.frequency_cap(MINIMIZER_MASK_FRACTION)));
+    fprintf(stderr, "* Masked %u of %u minimizers (%u postings)\n",
+        index.masked_keys(), (unsigned int) index.keys().size(), index.masked_postings());
+}
+
 int main(int argc, char **argv) {
 
     setup_cmd_interface(argc, argv);
@@ -271,42 +913,176 @@ int main(int argc, char **argv) {
       exit(1);
     }
 
-    vector<Read> reads;
+    if (MINIMIZER_LEN < 1 || MINIMIZER_LEN > MAX_NSTRING_LEN || WINDOW_LEN < MINIMIZER_LEN) {
+      fprintf(stderr, "Minimizer length has to be between 1 and %d, and at most the window length.\n",
+          MAX_NSTRING_LEN);
+      exit(1);
+    }
+    if (MIN_CHAIN_SCORE < 0) MIN_CHAIN_SCORE = MINIMIZER_LEN;
+    if (BINARY_OUTPUT && OUTPUT_FILE == NULL) {
+      fprintf(stderr, "Binary output needs an output file (-o), its header is written at the end.\n");
+      exit(1);
+    }
+    if (BLOCKS_NUM < 1 || BLOCK_ONE < 0 || BLOCK_ONE > BLOCK_TWO || BLOCK_TWO >= BLOCKS_NUM) {
+      fprintf(stderr, "Block pair (-j) has to be i,j with 0 <= i <= j < number of blocks (-p).\n");
+      exit(1);
+    }
+    // 0 is off, a given size below 1 is -1
+    if (SKETCH_SIZE < 0 || SKETCH_SIZE > USHRT_MAX) {
+      fprintf(stderr, "Sketch size (-z) has to be between 1 and %d.\n", USHRT_MAX);
+      exit(1);
+    }
+    if (MIN_JACCARD >= 0 && SKETCH_SIZE == 0) {
+      fprintf(stderr, "Minimum Jaccard similarity (-r) applies only to sketches (-z).\n");
+      exit(1);
+    }
+    if (MIN_JACCARD < 0) MIN_JACCARD = 0.02;
+    if (SKETCH_SIZE > 0 && (BATCH_FILE != NULL || SAVE_INDEX_FILE != NULL || LOAD_INDEX_FILE != NULL)) {
+      fprintf(stderr, "Sketches (-z) cannot be saved, loaded or added to (-x, -i, -u).\n");
+      exit(1);
+    }
+    if (EXACT_MIN_OVERLAP > 0 && (SKETCH_SIZE > 0 || BATCH_FILE != NULL || SAVE_INDEX_FILE != NULL ||
+          LOAD_INDEX_FILE != NULL || BLOCKS_NUM > 1 || MAX_CANDIDATES > 0)) {
+      fprintf(stderr, "Exact overlaps (-y) work on all the reads at once, without -z, -x, -i, -u, -p or -n.\n");
+      exit(1);
+    }
+    if (collapser != NULL && (BATCH_FILE != NULL || BLOCKS_NUM > 1)) {
+      fprintf(stderr, "Identical reads (-c) are collapsed over all the reads at once, without -u or -p.\n");
+      exit(1);
+    }
+    if (BLOCKS_NUM > 1 && BATCH_FILE != NULL) {
+      fprintf(stderr, "Batches (-u) cannot be added to block pairs (-p).\n");
+      exit(1);
+    }
+
+    ReadStore reads;
 
     // initialize a thread pool used for finding overlaps
     pool = new ThreadPool(THREADS_NUM);
 
-    int reads_size = read_from_afg(reads, INPUT_FILE);
+    // block b holds reads from block_start(b) to block_start(b + 1)
+    int total_reads = BLOCKS_NUM > 1 ? AMOS::count_reads(INPUT_FILE) : 0;
+    auto block_start = [total_reads] (int b) {
+      if (BLOCKS_NUM == 1) return b == 0 ? 0 : INT_MAX;
+      return (int) ((long long) total_reads * b / BLOCKS_NUM);
+    };
+
+    // the index is built for the second block of the pair
+    int reads_size = read_from_afg(reads, INPUT_FILE, block_start(BLOCK_TWO), block_start(BLOCK_TWO + 1));
     fprintf(stderr, "* Read %d strings...\n", reads_size);
+    if (BLOCKS_NUM > 1) {
+      fprintf(stderr, "* Block pair %d,%d of %d blocks (%d reads)\n", BLOCK_ONE, BLOCK_TWO, BLOCKS_NUM, total_reads);
+    }
+    if (collapser != NULL) {
+      unsigned int most_copies = 1;
+      for (unsigned int r = 0; r < reads.size(); ++r) most_copies = std::max(most_copies, collapser->multiplicity(r));
+      fprintf(stderr, "* Collapsed %u identical reads into %u (at most %u copies of a read)\n",
+          (unsigned int) collapser->duplicates().size(), reads.size(), most_copies);
+    }
+    fprintf(stderr, "* Packed %llu bases into %llu bytes\n",
+        (unsigned long long) reads.bases(), (unsigned long long) reads.memory());
 
     fprintf(stderr, "* Alignment band radius: %d\n", ALIGNMENT_BAND_RADIUS);
     fprintf(stderr, "* Number of threads: %d\n", THREADS_NUM);
     fprintf(stderr, "* Maximum error rate: %lf\n", MAXIMUM_ERROR_RATE);
-    fprintf(stderr, "* Merge radius: %d\n", MERGE_RADIUS);
-    fprintf(stderr, "* Offset wiggle: %d\n", OFFSET_WIGGLE);
-
-    Timer mtimer("calculating minimizers");
-    // create a bank of all minimizers so finding appropriate read pairs could be efficient.
-    Minimizer *m = new Minimizer(16, 20);
-    for (int i = 0, len = reads.size(); i < len; ++i) {
-      m->calculate_and_store(i, reads[i].sequence);
+    fprintf(stderr, "* Maximum chain gap: %d\n", MAX_CHAIN_GAP);
+    fprintf(stderr, "* Minimum chain score: %d\n", MIN_CHAIN_SCORE);
+    if (ANCHORED_MIN_READ_LEN != INT_MAX) {
+      fprintf(stderr, "* Anchored alignment for reads of at least %d bases\n", ANCHORED_MIN_READ_LEN);
+    }
+    fprintf(stderr, "* Minimizer mask fraction: %lf\n", MINIMIZER_MASK_FRACTION);
+    fprintf(stderr, "* Alignment kernel: %s\n", simd_level_name(simd_level()));
+
+    unsigned int first_new = 0;
+    Minimizer *m = NULL;
+    Sketch *sketch = NULL;
+    FMIndex *fm = NULL;
+    if (EXACT_MIN_OVERLAP > 0) {
+      fm = new FMIndex();
+      Timer ftimer("building the FM-index");
+      fm->build(reads);
+      ftimer.end();
+      fprintf(stderr, "* FM-index of %llu symbols in %llu bytes, exact overlaps of at least %d bases\n",
+          (unsigned long long) fm->size(), (unsigned long long) fm->memory(), EXACT_MIN_OVERLAP);
+    } else if (SKETCH_SIZE > 0) {
+      sketch = new Sketch(MINIMIZER_LEN, SKETCH_SIZE);
+      fprintf(stderr, "* Sketches of %d k-mers of length %d, minimum Jaccard similarity %lf\n",
+          SKETCH_SIZE, MINIMIZER_LEN, MIN_JACCARD);
+
+      Timer stimer("calculating sketches");
+      sketch->calculate_and_store(reads, pool, 0);
+      sketch->freeze(pool);
+      stimer.end();
+    } else {
+      m = build_minimizers(reads, &first_new);
     }
-    mtimer.end();
 
-    Timer ftimer("calculating forward overlaps");
-    find_overlaps(reads, m, OFFSET_WIGGLE, MERGE_RADIUS, true);
-    ftimer.end();
+    // reads of the first block are only looked up in the index of the second one
+    if (BLOCK_ONE != BLOCK_TWO) {
+      first_new = reads.size();
+      reads_size = read_from_afg(reads, INPUT_FILE, block_start(BLOCK_ONE), block_start(BLOCK_ONE + 1));
+      fprintf(stderr, "* Read %d strings of block %d...\n", reads_size, BLOCK_ONE);
+    }
 
-    Timer btimer("calculating backward overlaps");
-    find_overlaps(reads, m, OFFSET_WIGGLE, MERGE_RADIUS, false);
-    btimer.end();
+    if (sketch != NULL) {
+      mask_frequent(sketch);
+    } else if (m != NULL) {
+      mask_frequent(m);
+    }
 
-    // cleaning up the mess
-    for (int i = 0, len = reads.size(); i < len; ++i) {
-        delete[] reads[i].sequence;
+    OVB::Header header;
+    open_output(&header);
+    header.reads = BLOCKS_NUM > 1 ? total_reads : reads.size();
+    // collapsed reads are left out of the store, but their overlaps are written
+    if (collapser != NULL) header.reads += collapser->duplicates().size();
+
+    // minimizers are canonical, so one pass finds both normal and innie overlaps
+    Timer otimer("calculating overlaps");
+    writer = new OverlapWriter(fileno(OUTPUT_FD));
+    if (fm != NULL) {
+      find_exact_overlaps(reads, fm);
+    } else if (sketch != NULL) {
+      find_overlaps(reads, sketch, first_new);
+    } else {
+      find_overlaps(reads, m, first_new);
+    }
+    if (collapser != NULL) output_duplicates(reads);
+    int error = writer->close();
+    if (error != 0) {
+      fprintf(stderr, "Writing overlaps failed: %s\n", strerror(error));
+      exit(1);
+    }
+    otimer.end();
+
+    if (BINARY_OUTPUT) {
+      header.overlaps += ovb_overlaps;
+      header.checksum += ovb_checksum;
+      if (OVB::write_header(fileno(OUTPUT_FD), header) != 0) {
+        fprintf(stderr, "Writing the .ovb header failed.\n");
+        exit(1);
+      }
+      fprintf(stderr, "* Written %llu overlaps in .ovb format\n", (unsigned long long) header.overlaps);
+    }
+    if (MAX_CANDIDATES > 0) {
+      long long unranked = unranked_pairs.load();
+      fprintf(stderr, "* Best %d candidates at each end of a read: dropped %lld of %lld candidate pairs\n",
+          MAX_CANDIDATES, unranked, unranked + candidate_pairs.load());
+    }
+    if (fm == NULL) {
+      report_prefilter();
+      fprintf(stderr, "* Skipped %lld postings of masked minimizers\n", skipped_postings.load());
+    }
+    if (sketch != NULL) {
+      fprintf(stderr, "* Jaccard similarity below %lf for %lld of %lld sketched pairs\n",
+          MIN_JACCARD, dissimilar_pairs.load(), sketched_pairs.load());
     }
 
+    // cleaning up the mess
+    delete writer;
     delete m;
+    delete sketch;
+    delete fm;
+    delete collapser;
     delete pool;
 
     fclose(OUTPUT_FD);
@@ -15,15 +15,20 @@ using std::pair;
 using std::swap;
 using std::vector;
 
-struct offset_t {
-  int index;
-  int lo_offset;
-  int hi_offset;
-  offset_t() {}
-  offset_t(unsigned int index, int offset) : index(index), lo_offset(offset), hi_offset(offset) {}
-};
+typedef MinimizerIndex minimizers_t;
 
-typedef HashList<nstring_t, std::pair<unsigned int, unsigned int>> minimizers_t;
+// approximates the number of errors in an overlap of given score and length
+inline int approximate_errors(double score, int len) {
+  return (score - len)/(INDEL_SCORE + GAP_SCORE + MISMATCH_SCORE);
+}
+
+// fewest errors approximate_errors can give for an overlap with this edit distance;
+// an indel adds 1/2 to len and INDEL_SCORE to score, a mismatch 1 and MISMATCH_SCORE
+inline int minimal_errors(int edit_distance) {
+  int indels = edit_distance * (1 - 2 * INDEL_SCORE) / 2;
+  int mismatches = edit_distance * (1 - MISMATCH_SCORE);
+  return std::min(indels, mismatches) / -(INDEL_SCORE + GAP_SCORE + MISMATCH_SCORE);
+}
 
 typedef struct Overlap {
   Read r1;
@@ -44,14 +49,14 @@ typedef struct Overlap {
   //
   // read a           -ahang     ---------------|--------------->
   // read b      -------------------|-------------->     -bhang
-  Overlap(Read& r1, Read& r2, const double& score, const pair<int, int>& start, const pair<int, int>& end,
+  Overlap(const Read& r1, const Read& r2, const double& score, const pair<int, int>& start, const pair<int, int>& end,
     const bool& first_forward, const bool& second_forward)
     : r1(r1), r2(r2), score(score), normal_overlap(first_forward) {
 
       assert(second_forward == true);
 
-      int len1 = strlen(r1.sequence);
-      int len2 = strlen(r2.sequence);
+      int len1 = r1.length;
+      int len2 = r2.length;
       int overlap_len_a = end.first - start.first;
       int overlap_len_b = end.second - start.second;
 
@@ -87,7 +92,7 @@ typedef struct Overlap {
       }
 
       int len = abs(end.first - start.first + end.second - start.second) / 2.;
-      errors = (score - len)/(INDEL_SCORE + GAP_SCORE + MISMATCH_SCORE);
+      errors = approximate_errors(score, len);
       error_rate = (double) errors / len;
     }
 } Overlap;
@@ -0,0 +1,158 @@
+#include "./overlap_writer.h"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+// tells apart writers in the thread-local slot lookup
+static std::atomic<unsigned int> writers(0);
+
+OverlapWriter::OverlapWriter(int fd, size_t block_size, size_t max_queued)
+    : _fd(fd), _block_size(block_size), _max_queued(max_queued), _id(++writers), _written(0),
+      _error(0), _queued(0), _closing(false) {
+
+    _tail = new_block();
+    _head = _tail;
+    _writer = std::thread(&OverlapWriter::run, this);
+}
+
+OverlapWriter::~OverlapWriter() {
+    close();
+    delete _tail;
+}
+
+OverlapWriter::block_t* OverlapWriter::new_block() {
+    block_t* block = new block_t();
+    block->next = NULL;
+    block->len = 0;
+    block->data.resize(_block_size);
+    return block;
+}
+
+OverlapWriter::slot_t* OverlapWriter::thread_slot() {
+    static thread_local unsigned int owner = 0;
+    static thread_local slot_t* slot = NULL;
+
+    if (owner != _id) {
+        std::lock_guard<std::mutex> lock(_slots_mutex);
+        _slots.push_back(std::unique_ptr<slot_t>(new slot_t()));
+        slot = _slots.back().get();
+        slot->block = new_block();
+        owner = _id;
+    }
+
+    return slot;
+}
+
+void OverlapWriter::write(const char* data, size_t len) {
+    slot_t* slot = thread_slot();
+    block_t* block = slot->block;
+
+    if (block->len + len > block->data.size()) {
+        if (block->len > 0) {
+            push(block);
+            block = slot->block = new_block();
+        }
+        // a record larger than a block gets a block of its own
+        if (len > block->data.size()) block->data.resize(len);
+    }
+
+    memcpy(&block->data[block->len], data, len);
+    block->len += len;
+}
+
+int OverlapWriter::close() {
+    if (!_writer.joinable()) return _error;
+
+    {
+        std::lock_guard<std::mutex> lock(_slots_mutex);
+        for (auto& slot : _slots) {
+            if (slot->block->len > 0) {
+                push(slot->block);
+            } else {
+                delete slot->block;
+            }
+        }
+        _slots.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_queue_mutex);
+        _closing = true;
+    }
+    _ready.notify_one();
+    _writer.join();
+    return _error;
+}
+
+unsigned long long OverlapWriter::written() const {
+    return _written;
+}
+
+void OverlapWriter::push(block_t* block) {
+    {
+        std::unique_lock<std::mutex> lock(_queue_mutex);
+        _space.wait(lock, [this] () { return _queued < _max_queued; });
+        ++_queued;
+    }
+
+    block->next.store(NULL, std::memory_order_relaxed);
+    block_t* prev = _head.exchange(block, std::memory_order_acq_rel);
+    prev->next.store(block, std::memory_order_release);
+
+    // notified under the lock, so the writer thread cannot miss it between finding the
+    // queue empty and waiting
+    std::lock_guard<std::mutex> lock(_queue_mutex);
+    _ready.notify_one();
+}
+
+OverlapWriter::block_t* OverlapWriter::pop() {
+    block_t* next = _tail->next.load(std::memory_order_acquire);
+    if (next == NULL) return NULL;
+
+    // the old tail was written by the previous pop, next is kept as the new one
+    delete _tail;
+    _tail = next;
+    return next;
+}
+
+void OverlapWriter::run() {
+    while (true) {
+        block_t* block = pop();
+        if (block != NULL) {
+            write_block(block);
+            // the block stays as the tail until the next pop, its data is not needed anymore
+            std::vector<char>().swap(block->data);
+
+            {
+                std::lock_guard<std::mutex> lock(_queue_mutex);
+                --_queued;
+            }
+            _space.notify_one();
+            continue;
+        }
+
+        // every block is linked by the time close sets closing
+        std::unique_lock<std::mutex> lock(_queue_mutex);
+        _ready.wait(lock, [this] () {
+            return _closing || _tail->next.load(std::memory_order_acquire) != NULL;
+        });
+        if (_closing && _tail->next.load(std::memory_order_acquire) == NULL) break;
+    }
+}
+
+void OverlapWriter::write_block(const block_t* block) {
+    // once a write failed, the output is cut anyway
+    if (_error != 0) return;
+
+    size_t done = 0;
+    while (done < block->len) {
+        ssize_t n = ::write(_fd, &block->data[done], block->len - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            _error = errno;
+            break;
+        }
+        done += n;
+    }
+    _written += done;
+}
@@ -0,0 +1,77 @@
+#ifndef OVERLAP_WRITER_H
+#define OVERLAP_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Output shared by the worker threads without locking on every record. Each thread appends
+// to its own block; full blocks go through a lock-free multi-producer queue to a writer
+// thread, which writes them to the file descriptor with large write(2) calls. Records
+// of one thread keep their order, records of different threads are interleaved by block.
+// At most max_queued full blocks wait for the writer thread, a thread handing over one more
+// waits until there is room.
+class OverlapWriter {
+ public:
+    explicit OverlapWriter(int fd, size_t block_size = 1 << 20, size_t max_queued = 64);
+    // closes the writer if it was not closed
+    ~OverlapWriter();
+
+    // appends data to the block of the calling thread
+    void write(const char* data, size_t len);
+
+    // hands over the blocks of all threads and waits until everything is written; no thread
+    // may write at the same time. Returns 0, or the errno of the first failed write(2), after
+    // which nothing more is written
+    int close();
+
+    // bytes written to the file descriptor so far
+    unsigned long long written() const;
+
+ private:
+    struct block_t {
+        std::atomic<block_t*> next;
+        size_t len;
+        std::vector<char> data;
+    };
+
+    // block a thread is currently filling
+    struct slot_t {
+        block_t* block;
+    };
+
+    block_t* new_block();
+    slot_t* thread_slot();
+
+    // Vyukov's intrusive queue: producers exchange the head, the writer thread follows
+    // next pointers from the tail, which is always a block already written (or the stub)
+    void push(block_t* block);
+    block_t* pop();
+
+    void run();
+    void write_block(const block_t* block);
+
+    int _fd;
+    size_t _block_size;
+    size_t _max_queued;
+    unsigned int _id;
+    std::atomic<block_t*> _head;
+    block_t* _tail;
+    std::atomic<unsigned long long> _written;
+    std::atomic<int> _error;
+    // guard the waits only, the queue itself stays lock-free
+    std::mutex _queue_mutex;
+    std::condition_variable _ready;
+    std::condition_variable _space;
+    size_t _queued;
+    bool _closing;
+    std::mutex _slots_mutex;
+    std::vector<std::unique_ptr<slot_t>> _slots;
+    std::thread _writer;
+};
+
+#endif
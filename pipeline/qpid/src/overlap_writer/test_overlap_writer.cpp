@@ -0,0 +1,179 @@
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "./overlap_writer.h"
+
+// reads back everything written to the file
+std::string contents(FILE* file) {
+    std::string result;
+    char chunk[4096];
+
+    fflush(file);
+    lseek(fileno(file), 0, SEEK_SET);
+    ssize_t n;
+    while ((n = read(fileno(file), chunk, sizeof(chunk))) > 0) {
+        result.append(chunk, n);
+    }
+    return result;
+}
+
+// every record of every thread is written whole, and records of a thread keep their order
+void test_threads(int threads_num, int records, size_t block_size, size_t max_queued = 64) {
+    FILE* file = tmpfile();
+    unsigned long long expected_bytes = 0;
+
+    {
+        OverlapWriter writer(fileno(file), block_size, max_queued);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threads_num; ++t) {
+            threads.push_back(std::thread([&writer, t, records] () {
+                char record[64];
+                for (int i = 0; i < records; ++i) {
+                    int len = snprintf(record, sizeof(record), "%d %d\n", t, i);
+                    writer.write(record, len);
+                }
+            }));
+        }
+        for (auto& thread : threads) thread.join();
+
+        for (int t = 0; t < threads_num; ++t) {
+            for (int i = 0; i < records; ++i) {
+                expected_bytes += snprintf(NULL, 0, "%d %d\n", t, i);
+            }
+        }
+
+        assert(writer.close() == 0);
+        assert(writer.written() == expected_bytes);
+    }
+
+    std::string written = contents(file);
+    assert(written.size() == expected_bytes);
+
+    std::vector<int> next(threads_num, 0);
+    const char* p = written.c_str();
+    while (*p != '\0') {
+        char* end;
+        int t = strtol(p, &end, 10);
+        int i = strtol(end, &end, 10);
+        assert(*end == '\n');
+        assert(t >= 0 && t < threads_num);
+        assert(next[t] == i);
+        ++next[t];
+        p = end + 1;
+    }
+    for (int t = 0; t < threads_num; ++t) {
+        assert(next[t] == records);
+    }
+
+    fclose(file);
+}
+
+// a record larger than a block, and a writer closed without any records
+void test_large_record() {
+    FILE* file = tmpfile();
+    std::string large(1000, 'x');
+
+    {
+        OverlapWriter writer(fileno(file), 16);
+        writer.write("a", 1);
+        writer.write(large.c_str(), large.size());
+        writer.write("b", 1);
+    }
+    assert(contents(file) == "a" + large + "b");
+
+    {
+        OverlapWriter empty(fileno(file));
+    }
+    assert(contents(file) == "a" + large + "b");
+
+    fclose(file);
+}
+
+// a failed write is reported by close, and nothing after it is written
+void test_write_error() {
+    int fd = open("/dev/full", O_WRONLY);
+    assert(fd >= 0);
+
+    OverlapWriter writer(fd, 16);
+    for (int i = 0; i < 1000; ++i) {
+        writer.write("0123456789", 10);
+    }
+    assert(writer.close() == ENOSPC);
+    assert(writer.written() == 0);
+    // closing again keeps the error
+    assert(writer.close() == ENOSPC);
+
+    close(fd);
+}
+
+// with nobody reading the pipe, the writer thread gets stuck and the thread writing
+// records has to wait for room in the queue instead of piling up blocks
+void test_backpressure() {
+    int fds[2];
+    assert(pipe(fds) == 0);
+
+    const int records = 1000;
+    const size_t block_size = 4096;
+    std::atomic<int> done(0);
+    std::string record(block_size, 'x');
+
+    OverlapWriter writer(fds[1], block_size, 2);
+    std::thread producer([&] () {
+        for (int i = 0; i < records; ++i) {
+            writer.write(record.c_str(), record.size());
+            ++done;
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    assert(done < records);
+
+    // draining the pipe lets everything through
+    unsigned long long read_bytes = 0;
+    std::thread reader([&] () {
+        char chunk[4096];
+        ssize_t n;
+        while ((n = read(fds[0], chunk, sizeof(chunk))) > 0) read_bytes += n;
+    });
+
+    producer.join();
+    assert(writer.close() == 0);
+    close(fds[1]);
+    reader.join();
+    assert(read_bytes == (unsigned long long) records * block_size);
+
+    close(fds[0]);
+}
+
+int main() {
+
+    printf("threads test: ");
+    test_threads(1, 1, 1 << 20);
+    test_threads(4, 10000, 64);
+    test_threads(16, 20000, 4096);
+    test_threads(8, 20000, 64, 1);
+    printf("OK\n");
+
+    printf("large record test: ");
+    test_large_record();
+    printf("OK\n");
+
+    printf("write error test: ");
+    test_write_error();
+    printf("OK\n");
+
+    printf("backpressure test: ");
+    test_backpressure();
+    printf("OK\n");
+
+    return 0;
+}
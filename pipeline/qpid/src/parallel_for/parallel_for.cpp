@@ -0,0 +1,48 @@
+#include "./parallel_for.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include "thread_pool/ThreadPool.h"
+
+// a claim takes 1 / (CHUNK_SHARE * workers) of the remaining items
+const unsigned int CHUNK_SHARE = 4;
+
+std::vector<worker_stats_t> parallel_for(ThreadPool* pool, int workers, unsigned int n,
+        const std::function<void(unsigned int, unsigned int)>& body, unsigned int min_chunk) {
+
+    std::vector<worker_stats_t> stats(workers);
+    std::atomic<unsigned int> next(0);
+    min_chunk = std::max(min_chunk, 1u);
+
+    auto work = [&stats, &next, &body, workers, n, min_chunk] (int w) {
+        worker_stats_t& s = stats[w];
+        s.busy_seconds = 0;
+        s.items = s.chunks = 0;
+
+        unsigned int begin = next.load();
+        while (begin < n) {
+            unsigned int chunk = std::max(min_chunk, (n - begin) / (CHUNK_SHARE * workers));
+            unsigned int end = begin + std::min(chunk, n - begin);
+            if (!next.compare_exchange_weak(begin, end)) continue;
+
+            auto start = std::chrono::steady_clock::now();
+            body(begin, end);
+            s.busy_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            s.items += end - begin;
+            s.chunks++;
+
+            begin = next.load();
+        }
+    };
+
+    std::vector<std::future<void>> results;
+    for (int w = 0; w < workers; ++w) {
+        results.push_back(pool->enqueue(work, w));
+    }
+    for (auto& result : results) {
+        result.get();
+    }
+
+    return stats;
+}
@@ -0,0 +1,24 @@
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <functional>
+#include <vector>
+
+class ThreadPool;
+
+// what a worker of parallel_for did
+struct worker_stats_t {
+    // time spent in the body
+    double busy_seconds;
+    unsigned int items;
+    unsigned int chunks;
+};
+
+// Calls body(begin, end) for ranges covering [0, n), from one task per worker on the pool.
+// Workers claim ranges from a shared counter instead of getting a task per item; every
+// claim takes a share of what is left (at least min_chunk items), so the first chunks are
+// large and the tail is split finely enough to keep all workers busy until the end.
+std::vector<worker_stats_t> parallel_for(ThreadPool* pool, int workers, unsigned int n,
+        const std::function<void(unsigned int, unsigned int)>& body, unsigned int min_chunk = 1);
+
+#endif
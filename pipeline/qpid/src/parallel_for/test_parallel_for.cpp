@@ -0,0 +1,66 @@
+#include <cassert>
+#include <cstdio>
+#include <atomic>
+#include <vector>
+#include "./parallel_for.h"
+#include "thread_pool/ThreadPool.h"
+
+// every item is visited exactly once, and the stats add up
+void test_coverage(ThreadPool* pool, int workers, unsigned int n, unsigned int min_chunk) {
+    std::vector<std::atomic<int>> visits(n);
+    for (auto& v : visits) v = 0;
+
+    std::atomic<unsigned int> calls(0);
+    auto stats = parallel_for(pool, workers, n, [&visits, &calls, min_chunk, n] (unsigned int begin, unsigned int end) {
+        assert(begin < end && end <= n);
+        assert(end - begin >= min_chunk || end == n);
+        for (unsigned int i = begin; i < end; ++i) visits[i]++;
+        calls++;
+    }, min_chunk);
+
+    for (unsigned int i = 0; i < n; ++i) {
+        assert(visits[i] == 1);
+    }
+
+    assert(stats.size() == (size_t) workers);
+    unsigned int items = 0, chunks = 0;
+    for (const worker_stats_t& s : stats) {
+        assert(s.busy_seconds >= 0);
+        items += s.items;
+        chunks += s.chunks;
+    }
+    assert(items == n);
+    assert(chunks == calls);
+}
+
+// chunks shrink towards the end of the range
+void test_guided(ThreadPool* pool) {
+    std::vector<unsigned int> sizes(1000000, 0);
+
+    parallel_for(pool, 1, sizes.size(), [&sizes] (unsigned int begin, unsigned int end) {
+        sizes[begin] = end - begin;
+    });
+
+    assert(sizes[0] == 1000000 / 4);
+    assert(sizes[sizes.size() - 1] == 1);
+}
+
+int main() {
+
+    ThreadPool pool(4);
+
+    printf("coverage test: ");
+    test_coverage(&pool, 1, 0, 1);
+    test_coverage(&pool, 1, 1, 1);
+    test_coverage(&pool, 4, 3, 1);
+    test_coverage(&pool, 4, 1000, 1);
+    test_coverage(&pool, 4, 100000, 16);
+    test_coverage(&pool, 8, 12345, 100);
+    printf("OK\n");
+
+    printf("guided chunks test: ");
+    test_guided(&pool);
+    printf("OK\n");
+
+    return 0;
+}
@@ -3,9 +3,11 @@
 
 typedef struct Read {
   int id;
-  char* sequence;
+  // 2-bit codes of the bases, see encode_bases
+  char* codes;
+  int length;
 
   Read() {}
-  Read(int idx, char* seq): id(idx), sequence(seq) {}
+  Read(int idx, char* codes, int length): id(idx), codes(codes), length(length) {}
 } Read;
 #endif
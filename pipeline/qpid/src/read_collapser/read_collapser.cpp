@@ -0,0 +1,50 @@
+#include "./read_collapser.h"
+#include "../encode/encode.h"
+#include <algorithm>
+#include <cstring>
+
+// FNV-1a over the codes and the length
+static uint64_t hash_codes(const char* codes, int len) {
+    uint64_t hash = 14695981039346656037ull ^ (uint64_t) len;
+    for (int i = 0; i < len; ++i) {
+        hash = (hash ^ (uint8_t) codes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+unsigned int ReadCollapser::add(ReadStore& reads, int id, const char* str, int len) {
+
+    _codes.resize(len + 1);
+    _reverse.resize(len + 1);
+    encode_bases(str, len, &_codes[0]);
+    reverse_complement_codes(&_codes[0], len, &_reverse[0]);
+
+    uint64_t forward_hash = hash_codes(&_codes[0], len);
+    uint64_t reverse_hash = hash_codes(&_reverse[0], len);
+    uint64_t hash = std::min(forward_hash, reverse_hash);
+
+    auto range = _by_hash.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        unsigned int read = it->second;
+        if (reads.length(read) != len) continue;
+
+        // representatives are stored as they came, in either orientation
+        _stored.resize(len + 1);
+        reads.unpack(read, &_stored[0]);
+        bool forward = memcmp(&_stored[0], &_codes[0], len) == 0;
+        if (!forward && memcmp(&_stored[0], &_reverse[0], len) != 0) continue;
+
+        duplicate_t duplicate;
+        duplicate.id = id;
+        duplicate.representative = read;
+        duplicate.forward = forward;
+        _duplicates.push_back(duplicate);
+        ++_copies[read];
+        return read;
+    }
+
+    unsigned int read = reads.add(id, str, len);
+    _by_hash.insert(std::make_pair(hash, read));
+    if (_copies.size() <= read) _copies.resize(read + 1, 1);
+    return read;
+}
@@ -0,0 +1,44 @@
+#ifndef READ_COLLAPSER_H
+#define READ_COLLAPSER_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "../read_store/read_store.h"
+
+// Collapses reads identical to an earlier one, in either orientation, as they are loaded:
+// only the first of identical reads (the representative) goes to the store, the others are
+// kept aside as duplicates of it. Reads are found by a hash of their codes in the orientation
+// that hashes lower, and compared base by base.
+class ReadCollapser {
+ public:
+    struct duplicate_t {
+        int id;
+        unsigned int representative;
+        // same orientation as the representative, not its reverse complement
+        bool forward;
+    };
+
+    // adds the read to the store unless it is a duplicate; returns the index of the read or
+    // of its representative
+    unsigned int add(ReadStore& reads, int id, const char* str, int len);
+
+    const std::vector<duplicate_t>& duplicates() const {
+        return _duplicates;
+    }
+
+    // copies of a read of the store, itself included
+    unsigned int multiplicity(unsigned int read) const {
+        return read < _copies.size() ? _copies[read] : 1;
+    }
+
+ private:
+    std::unordered_multimap<uint64_t, unsigned int> _by_hash;
+    std::vector<duplicate_t> _duplicates;
+    std::vector<unsigned int> _copies;
+    std::vector<char> _codes;
+    std::vector<char> _reverse;
+    std::vector<char> _stored;
+};
+
+#endif
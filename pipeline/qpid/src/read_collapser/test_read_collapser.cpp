@@ -0,0 +1,110 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "./read_collapser.h"
+
+std::string random_read(int len) {
+    std::string str(len, 'A');
+    for (int i = 0; i < len; ++i) {
+        str[i] = "ACGT"[rand() % 4];
+    }
+    return str;
+}
+
+std::string reverse_complement(const std::string& str) {
+    std::string rc(str.rbegin(), str.rend());
+    for (char& c : rc) {
+        c = c == 'A' ? 'T' : c == 'C' ? 'G' : c == 'G' ? 'C' : 'A';
+    }
+    return rc;
+}
+
+// copies in either orientation and either case go to the first read, everything else is stored
+void test_collapse() {
+    ReadStore reads;
+    ReadCollapser collapser;
+
+    std::string a = random_read(300), b = random_read(300);
+    std::string lower_a = a;
+    for (char& c : lower_a) c = c - 'A' + 'a';
+
+    assert(collapser.add(reads, 10, a.c_str(), a.size()) == 0);
+    assert(collapser.add(reads, 11, b.c_str(), b.size()) == 1);
+    assert(collapser.add(reads, 12, a.c_str(), a.size()) == 0);
+    assert(collapser.add(reads, 13, reverse_complement(a).c_str(), a.size()) == 0);
+    assert(collapser.add(reads, 14, lower_a.c_str(), a.size()) == 0);
+    // a prefix of a read, and a read one base off, are reads of their own
+    assert(collapser.add(reads, 15, a.c_str(), a.size() - 1) == 2);
+    std::string c = a;
+    c[150] = c[150] == 'A' ? 'C' : 'A';
+    assert(collapser.add(reads, 16, c.c_str(), c.size()) == 3);
+    assert(collapser.add(reads, 17, reverse_complement(b).c_str(), b.size()) == 1);
+
+    assert(reads.size() == 4);
+    assert(reads.id(0) == 10 && reads.id(1) == 11 && reads.id(2) == 15 && reads.id(3) == 16);
+    assert(collapser.multiplicity(0) == 4 && collapser.multiplicity(1) == 2);
+    assert(collapser.multiplicity(2) == 1 && collapser.multiplicity(3) == 1);
+
+    const auto& duplicates = collapser.duplicates();
+    assert(duplicates.size() == 4);
+    assert(duplicates[0].id == 12 && duplicates[0].representative == 0 && duplicates[0].forward);
+    assert(duplicates[1].id == 13 && duplicates[1].representative == 0 && !duplicates[1].forward);
+    assert(duplicates[2].id == 14 && duplicates[2].forward);
+    assert(duplicates[3].id == 17 && duplicates[3].representative == 1 && !duplicates[3].forward);
+}
+
+// a palindromic read equals its reverse complement, and is a forward copy of itself
+void test_palindrome() {
+    ReadStore reads;
+    ReadCollapser collapser;
+
+    std::string half = random_read(50);
+    std::string palindrome = half + reverse_complement(half);
+
+    assert(collapser.add(reads, 1, palindrome.c_str(), palindrome.size()) == 0);
+    assert(collapser.add(reads, 2, palindrome.c_str(), palindrome.size()) == 0);
+    assert(collapser.duplicates().size() == 1 && collapser.duplicates()[0].forward);
+}
+
+// many reads with few distinct sequences
+void test_many(int reads_num, int distinct) {
+    ReadStore reads;
+    ReadCollapser collapser;
+
+    std::vector<std::string> sequences;
+    for (int i = 0; i < distinct; ++i) sequences.push_back(random_read(100 + rand() % 100));
+
+    std::vector<int> seen(distinct, 0);
+    for (int i = 0; i < reads_num; ++i) {
+        int s = rand() % distinct;
+        std::string read = rand() % 2 ? sequences[s] : reverse_complement(sequences[s]);
+        collapser.add(reads, i, read.c_str(), read.size());
+        ++seen[s];
+    }
+
+    unsigned int stored = 0, total = 0;
+    for (int s = 0; s < distinct; ++s) stored += seen[s] > 0;
+    for (unsigned int r = 0; r < reads.size(); ++r) total += collapser.multiplicity(r);
+    assert(reads.size() == stored);
+    assert(total == (unsigned int) reads_num);
+    assert(collapser.duplicates().size() == reads_num - stored);
+}
+
+int main() {
+
+    srand(3);
+
+    printf("collapse test: ");
+    test_collapse();
+    test_palindrome();
+    printf("OK\n");
+
+    printf("many reads test: ");
+    test_many(10000, 50);
+    test_many(1000, 1000);
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include "./read_store.h"
+#include "../encode/encode.h"
+#include <cstring>
+
+// codes of the 4 bases of every packed byte, in order and reverse complemented
+struct unpack_tables_t {
+    char forward[256][4];
+    char reverse_complement[256][4];
+
+    unpack_tables_t() {
+        for (int b = 0; b < 256; ++b) {
+            for (int k = 0; k < 4; ++k) {
+                forward[b][k] = (b >> (2 * k)) & 0x3;
+                reverse_complement[b][k] = 0x3 - ((b >> (2 * (3 - k))) & 0x3);
+            }
+        }
+    }
+};
+
+static const unpack_tables_t TABLES;
+
+ReadStore::ReadStore() : _bases(0) {
+}
+
+void ReadStore::reserve(unsigned int reads, uint64_t bases) {
+    _packed.reserve((bases + 3) / 4);
+    _offsets.reserve(reads);
+    _lengths.reserve(reads);
+    _ids.reserve(reads);
+}
+
+unsigned int ReadStore::add(int id, const char* str, int len) {
+
+    static thread_local std::vector<char> codes;
+    codes.resize(len);
+    encode_bases(str, len, &codes[0]);
+
+    _packed.resize((_bases + len + 3) / 4, 0);
+    for (int i = 0; i < len; ++i) {
+        uint64_t base = _bases + i;
+        _packed[base >> 2] |= codes[i] << (2 * (base & 0x3));
+    }
+
+    _offsets.push_back(_bases);
+    _lengths.push_back(len);
+    _ids.push_back(id);
+    _bases += len;
+
+    return _ids.size() - 1;
+}
+
+void ReadStore::unpack(unsigned int read, char* codes) const {
+
+    uint64_t base = _offsets[read];
+    int len = _lengths[read], i = 0;
+
+    // up to the first whole byte, then 4 bases at a time
+    for (; i < len && (base & 0x3); ++i, ++base) {
+        codes[i] = code(read, i);
+    }
+    for (; i + 4 <= len; i += 4, base += 4) {
+        memcpy(codes + i, TABLES.forward[_packed[base >> 2]], 4);
+    }
+    for (; i < len; ++i) {
+        codes[i] = code(read, i);
+    }
+}
+
+void ReadStore::unpack_reverse_complement(unsigned int read, char* codes) const {
+
+    uint64_t base = _offsets[read];
+    int len = _lengths[read], i = 0;
+
+    // base i of the read is written to len - i - 1
+    for (; i < len && (base & 0x3); ++i, ++base) {
+        codes[len - i - 1] = 0x3 - code(read, i);
+    }
+    for (; i + 4 <= len; i += 4, base += 4) {
+        memcpy(codes + len - i - 4, TABLES.reverse_complement[_packed[base >> 2]], 4);
+    }
+    for (; i < len; ++i) {
+        codes[len - i - 1] = 0x3 - code(read, i);
+    }
+}
+
+const Read ReadStore::get(unsigned int read, std::vector<char>& buffer) const {
+
+    buffer.resize(_lengths[read]);
+    unpack(read, buffer.data());
+
+    return Read(_ids[read], buffer.data(), _lengths[read]);
+}
+
+const Read ReadStore::get_reverse_complement(unsigned int read, std::vector<char>& buffer) const {
+
+    buffer.resize(_lengths[read]);
+    unpack_reverse_complement(read, buffer.data());
+
+    return Read(_ids[read], buffer.data(), _lengths[read]);
+}
+
+uint64_t ReadStore::memory() const {
+    return _packed.capacity() * sizeof(uint8_t) + _offsets.capacity() * sizeof(uint64_t)
+        + _lengths.capacity() * sizeof(int) + _ids.capacity() * sizeof(int);
+}
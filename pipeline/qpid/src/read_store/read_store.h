@@ -0,0 +1,63 @@
+#ifndef READ_STORE_H
+#define READ_STORE_H
+
+#include <cstdint>
+#include <vector>
+#include "../read.h"
+
+// All reads in one contiguous buffer, 2 bits per base (4 bases per byte, the first one in
+// the lowest bits), with offsets and lengths kept aside. Reads are unpacked into 2-bit codes
+// (see encode_bases), forward or reverse complemented, into a buffer the caller owns and reuses.
+class ReadStore {
+ public:
+    ReadStore();
+
+    // room for reads and bases, so adding them does not reallocate
+    void reserve(unsigned int reads, uint64_t bases);
+
+    // encodes and packs the letters, returns index of the read
+    unsigned int add(int id, const char* str, int len);
+
+    unsigned int size() const {
+        return _ids.size();
+    }
+
+    int id(unsigned int read) const {
+        return _ids[read];
+    }
+
+    int length(unsigned int read) const {
+        return _lengths[read];
+    }
+
+    // 2-bit code of a single base
+    char code(unsigned int read, int pos) const {
+        uint64_t base = _offsets[read] + pos;
+        return (_packed[base >> 2] >> (2 * (base & 0x3))) & 0x3;
+    }
+
+    // writes length(read) codes into codes
+    void unpack(unsigned int read, char* codes) const;
+    // writes codes of the reverse complement, no intermediate copy
+    void unpack_reverse_complement(unsigned int read, char* codes) const;
+
+    // read of the given index, its codes unpacked into buffer, which it points to
+    const Read get(unsigned int read, std::vector<char>& buffer) const;
+    const Read get_reverse_complement(unsigned int read, std::vector<char>& buffer) const;
+
+    uint64_t bases() const {
+        return _bases;
+    }
+
+    // bytes taken by the packed bases and the tables
+    uint64_t memory() const;
+
+ private:
+    uint64_t _bases;
+    std::vector<uint8_t> _packed;
+    std::vector<uint64_t> _offsets;
+    std::vector<int> _lengths;
+    std::vector<int> _ids;
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "./read_store.h"
+#include "../encode/encode.h"
+
+// unpacked reads match the encoded letters, at every offset into a packed byte
+void test_unpack(int reads_num, int max_len) {
+    ReadStore store;
+    std::vector<std::string> strs;
+
+    srand(reads_num + max_len);
+    for (int i = 0; i < reads_num; ++i) {
+        int len = rand() % (max_len + 1);
+        std::string str(len, 'A');
+        for (int j = 0; j < len; ++j) {
+            str[j] = "ACGTacgtN"[rand() % 9];
+        }
+
+        assert(store.add(100 + i, str.c_str(), len) == (unsigned int) i);
+        strs.push_back(str);
+    }
+    assert(store.size() == (unsigned int) reads_num);
+
+    std::vector<char> buffer, expected, expected_rc;
+    for (int i = 0; i < reads_num; ++i) {
+        int len = strs[i].size();
+        expected.resize(len + 1);
+        expected_rc.resize(len + 1);
+        encode_bases(strs[i].c_str(), len, &expected[0]);
+        reverse_complement_codes(&expected[0], len, &expected_rc[0]);
+
+        assert(store.id(i) == 100 + i);
+        assert(store.length(i) == len);
+        for (int j = 0; j < len; ++j) {
+            assert(store.code(i, j) == expected[j]);
+        }
+
+        const Read read = store.get(i, buffer);
+        assert(read.id == 100 + i && read.length == len);
+        assert(std::equal(read.codes, read.codes + len, expected.begin()));
+
+        const Read rc = store.get_reverse_complement(i, buffer);
+        assert(rc.id == 100 + i && rc.length == len);
+        assert(std::equal(rc.codes, rc.codes + len, expected_rc.begin()));
+    }
+}
+
+void test_memory() {
+    ReadStore store;
+    std::string str(1000, 'G');
+
+    store.reserve(100, 100 * 1000);
+    for (int i = 0; i < 100; ++i) {
+        store.add(i, str.c_str(), str.size());
+    }
+
+    assert(store.bases() == 100 * 1000);
+    // a quarter of a byte per base, and the tables
+    assert(store.memory() == 100 * 1000 / 4 + 100 * (sizeof(uint64_t) + 2 * sizeof(int)));
+}
+
+int main() {
+
+    printf("unpack test: ");
+    test_unpack(1, 0);
+    test_unpack(100, 10);
+    test_unpack(1000, 300);
+    printf("OK\n");
+
+    printf("memory test: ");
+    test_memory();
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "./merge.h"
+#include "ovb_convert/convert.h"
+
+#include <algorithm>
+#include <cstdio>
+
+OVB::Overlap swap_reads(const OVB::Overlap& overlap) {
+    OVB::Overlap swapped = overlap;
+    swapped.read_one = overlap.read_two;
+    swapped.read_two = overlap.read_one;
+
+    if (overlap.adj == 'I') {
+      swapped.a_hang = overlap.b_hang;
+      swapped.b_hang = overlap.a_hang;
+    } else {
+      swapped.a_hang = -overlap.a_hang;
+      swapped.b_hang = -overlap.b_hang;
+    }
+
+    return swapped;
+}
+
+long long read_shard(const char* filename, std::vector<OVB::Overlap>& overlaps) {
+
+    if (is_ovb_file(filename)) {
+      OVB::Reader reader;
+      if (reader.open(filename) != 0 || !reader.verify()) return -1;
+
+      overlaps.reserve(overlaps.size() + reader.size());
+      for (uint64_t i = 0, len = reader.size(); i < len; ++i) {
+        overlaps.push_back(reader.get(i));
+      }
+      return reader.size();
+    }
+
+    FILE* in = fopen(filename, "r");
+    if (in == NULL) return -1;
+
+    long long read = read_afg_overlaps(in, [&overlaps] (const OVB::Overlap& overlap) {
+      overlaps.push_back(overlap);
+    });
+    fclose(in);
+
+    return read;
+}
+
+long long dedupe_overlaps(std::vector<OVB::Overlap>& overlaps) {
+
+    for (auto& overlap : overlaps) {
+      if (overlap.read_one > overlap.read_two) overlap = swap_reads(overlap);
+    }
+
+    // the best one of a pair comes first, ties broken by hangs so that the order of shards
+    // does not matter
+    std::sort(overlaps.begin(), overlaps.end(), [] (const OVB::Overlap& a, const OVB::Overlap& b) {
+      if (a.read_one != b.read_one) return a.read_one < b.read_one;
+      if (a.read_two != b.read_two) return a.read_two < b.read_two;
+      if (a.adj != b.adj) return a.adj > b.adj;
+      if (a.score != b.score) return a.score > b.score;
+      if (a.a_hang != b.a_hang) return a.a_hang < b.a_hang;
+      return a.b_hang < b.b_hang;
+    });
+
+    auto end = std::unique(overlaps.begin(), overlaps.end(), [] (const OVB::Overlap& a, const OVB::Overlap& b) {
+      return a.read_one == b.read_one && a.read_two == b.read_two && a.adj == b.adj;
+    });
+
+    long long removed = overlaps.end() - end;
+    overlaps.erase(end, overlaps.end());
+    return removed;
+}
+
+int write_merged(const char* filename, const std::vector<OVB::Overlap>& overlaps, bool binary,
+    uint32_t reads) {
+
+    if (binary) {
+      OVB::Writer writer;
+      if (writer.open(filename, reads) != 0) return -1;
+      for (const auto& overlap : overlaps) {
+        writer.write(overlap);
+      }
+      return writer.close();
+    }
+
+    FILE *out = fopen(filename, "w");
+    if (out == nullptr) return -1;
+    for (const auto& overlap : overlaps) {
+      write_afg_overlap(out, overlap);
+    }
+
+    // buffered records only fail on the way out
+    int result = ferror(out) ? -1 : 0;
+    if (fclose(out) != 0) result = -1;
+    return result;
+}
@@ -0,0 +1,26 @@
+#ifndef SHARD_MERGE_H
+#define SHARD_MERGE_H
+
+#include <vector>
+#include "lib/ovb/ovb.h"
+
+// Merging of overlap shards written by qpid jobs of block pairs (-p, -j).
+
+// the same overlap with the reads the other way around: hangs of a normal overlap change
+// their signs, the ones of an innie change places
+OVB::Overlap swap_reads(const OVB::Overlap& overlap);
+
+// appends the overlaps of a shard, AFG or .ovb; returns their number, or -1 if the shard
+// cannot be read
+long long read_shard(const char* filename, std::vector<OVB::Overlap>& overlaps);
+
+// turns every overlap the smaller read first, sorts them by reads and keeps the best scoring
+// one of each pair of reads and adjacency; returns the number of overlaps removed
+long long dedupe_overlaps(std::vector<OVB::Overlap>& overlaps);
+
+// writes the overlaps to an AFG file, or an .ovb file for the given number of reads if
+// binary; 0, or -1 if the file cannot be opened or written
+int write_merged(const char* filename, const std::vector<OVB::Overlap>& overlaps, bool binary,
+    uint32_t reads);
+
+#endif
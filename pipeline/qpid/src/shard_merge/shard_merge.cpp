@@ -0,0 +1,66 @@
+#include "./merge.h"
+#include "lib/parsero/parsero.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+unsigned int READS_NUM = 0;
+bool BINARY_OUTPUT = false;
+char *OUTPUT_FILE = NULL;
+std::vector<char*> SHARD_FILES;
+
+void setup_cmd_interface(int argc, char **argv) {
+
+  parsero::set_header("Merges overlap shards of qpid jobs (AFG or .ovb) into one file, "
+      "keeping the best overlap of each pair of reads.");
+
+  parsero::add_option("b", "binary output (.ovb)",
+      [] (char *) { BINARY_OUTPUT = true; }
+      );
+
+  parsero::add_option("n:", "number of reads the overlaps refer to, stored in the .ovb header",
+      [] (char *option) { READS_NUM = atoi(option); }
+      );
+
+  parsero::add_argument("output",
+      [] (char *filename) { OUTPUT_FILE = filename; }
+      );
+
+  parsero::add_arguments_list("shards",
+      [] (char *filename) { SHARD_FILES.push_back(filename); }
+      );
+
+  parsero::parse(argc, argv);
+}
+
+int main(int argc, char **argv) {
+
+    setup_cmd_interface(argc, argv);
+
+    if (OUTPUT_FILE == nullptr || SHARD_FILES.empty()) {
+      parsero::help(argv[0]);
+      exit(1);
+    }
+
+    std::vector<OVB::Overlap> overlaps;
+    for (auto shard : SHARD_FILES) {
+      if (read_shard(shard, overlaps) < 0) {
+        fprintf(stderr, "Reading shard %s failed\n", shard);
+        exit(1);
+      }
+    }
+    fprintf(stderr, "* Read %llu overlaps from %d shards\n",
+        (unsigned long long) overlaps.size(), (int) SHARD_FILES.size());
+
+    long long removed = dedupe_overlaps(overlaps);
+    fprintf(stderr, "* Removed %lld duplicate overlaps\n", removed);
+
+    if (write_merged(OUTPUT_FILE, overlaps, BINARY_OUTPUT, READS_NUM) != 0) {
+      fprintf(stderr, "Writing %s failed\n", OUTPUT_FILE);
+      exit(1);
+    }
+
+    fprintf(stderr, "* Written %llu overlaps\n", (unsigned long long) overlaps.size());
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "./merge.h"
+#include "ovb_convert/convert.h"
+
+// path of a new empty file
+std::string temp_file() {
+    char path[] = "/tmp/test_shard_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    return path;
+}
+
+OVB::Overlap make_overlap(int one, int two, int score, int a_hang, int b_hang, char adj) {
+    OVB::Overlap overlap;
+    overlap.read_one = one;
+    overlap.read_two = two;
+    overlap.score = score;
+    overlap.a_hang = a_hang;
+    overlap.b_hang = b_hang;
+    overlap.adj = adj;
+    return overlap;
+}
+
+bool same(const OVB::Overlap& a, const OVB::Overlap& b) {
+    return a.read_one == b.read_one && a.read_two == b.read_two && a.score == b.score &&
+        a.a_hang == b.a_hang && a.b_hang == b.b_hang && a.adj == b.adj;
+}
+
+void test_swap() {
+    OVB::Overlap normal = make_overlap(3, 7, 100, 20, -5, 'N');
+    OVB::Overlap swapped = swap_reads(normal);
+    assert(same(swapped, make_overlap(7, 3, 100, -20, 5, 'N')));
+    assert(same(swap_reads(swapped), normal));
+
+    OVB::Overlap innie = make_overlap(3, 7, 100, 20, -5, 'I');
+    assert(same(swap_reads(innie), make_overlap(7, 3, 100, -5, 20, 'I')));
+    assert(same(swap_reads(swap_reads(innie)), innie));
+}
+
+// the same pair from two shards, once the other way around, is kept once, with the best score
+void test_dedupe() {
+    std::vector<OVB::Overlap> overlaps;
+    overlaps.push_back(make_overlap(5, 1, 90, 10, 12, 'N'));
+    overlaps.push_back(make_overlap(1, 5, 95, -10, -12, 'N'));
+    overlaps.push_back(make_overlap(1, 5, 80, 3, 4, 'I'));
+    overlaps.push_back(make_overlap(2, 3, 70, 1, 1, 'N'));
+    overlaps.push_back(make_overlap(3, 2, 70, -1, -1, 'N'));
+
+    assert(dedupe_overlaps(overlaps) == 2);
+    assert(overlaps.size() == 3);
+    assert(same(overlaps[0], make_overlap(1, 5, 95, -10, -12, 'N')));
+    assert(same(overlaps[1], make_overlap(1, 5, 80, 3, 4, 'I')));
+    assert(same(overlaps[2], make_overlap(2, 3, 70, 1, 1, 'N')));
+
+    std::vector<OVB::Overlap> none;
+    assert(dedupe_overlaps(none) == 0 && none.empty());
+}
+
+// shards of both formats are read, a missing one is not
+void test_read_shard() {
+    std::string afg = temp_file(), ovb = temp_file();
+
+    FILE* out = fopen(afg.c_str(), "w");
+    write_afg_overlap(out, make_overlap(1, 2, 100, 5, 6, 'N'));
+    write_afg_overlap(out, make_overlap(4, 3, 90, -5, -6, 'I'));
+    fclose(out);
+
+    FILE* in = fopen(afg.c_str(), "r");
+    assert(afg_to_ovb(in, ovb.c_str(), 10) == 2);
+    fclose(in);
+
+    std::vector<OVB::Overlap> overlaps;
+    assert(read_shard(afg.c_str(), overlaps) == 2);
+    assert(read_shard(ovb.c_str(), overlaps) == 2);
+    assert(overlaps.size() == 4);
+    assert(same(overlaps[1], overlaps[3]));
+    assert(same(overlaps[1], make_overlap(4, 3, 90, -5, -6, 'I')));
+
+    assert(dedupe_overlaps(overlaps) == 2);
+    assert(same(overlaps[1], make_overlap(3, 4, 90, -6, -5, 'I')));
+
+    assert(read_shard("/nonexistent/shard.afg", overlaps) == -1);
+
+    unlink(afg.c_str());
+    unlink(ovb.c_str());
+}
+
+// the merged file is read back in either format, and a full device fails either way
+void test_write_merged() {
+    std::string afg = temp_file(), ovb = temp_file();
+
+    std::vector<OVB::Overlap> overlaps;
+    for (int i = 0; i < 1000; ++i) {
+        overlaps.push_back(make_overlap(i, i + 1, 100, 5, 6, i % 2 ? 'N' : 'I'));
+    }
+
+    assert(write_merged(afg.c_str(), overlaps, false, 0) == 0);
+    assert(write_merged(ovb.c_str(), overlaps, true, 1001) == 0);
+    std::vector<OVB::Overlap> back;
+    assert(read_shard(afg.c_str(), back) == 1000);
+    assert(read_shard(ovb.c_str(), back) == 1000);
+    for (int i = 0; i < 1000; ++i) {
+        assert(same(back[i], overlaps[i]) && same(back[1000 + i], overlaps[i]));
+    }
+
+    assert(write_merged("/dev/full", overlaps, false, 0) == -1);
+    assert(write_merged("/dev/full", overlaps, true, 1001) == -1);
+    assert(write_merged("/nonexistent/merged.afg", overlaps, false, 0) == -1);
+
+    unlink(afg.c_str());
+    unlink(ovb.c_str());
+}
+
+int main() {
+
+    printf("swap test: ");
+    test_swap();
+    printf("OK\n");
+
+    printf("dedupe test: ");
+    test_dedupe();
+    printf("OK\n");
+
+    printf("read shard test: ");
+    test_read_shard();
+    printf("OK\n");
+
+    printf("write merged test: ");
+    test_write_merged();
+    printf("OK\n");
+
+    return 0;
+}
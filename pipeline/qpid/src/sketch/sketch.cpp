@@ -0,0 +1,134 @@
+#include "./sketch.h"
+#include <cassert>
+#include <algorithm>
+#include <climits>
+#include <future>
+#include "thread_pool/ThreadPool.h"
+
+// upper bound on blocks of reads, each of them is a task and a block of the index
+const unsigned int SKETCH_BLOCKS = 64;
+
+// murmur3 finalizer; it is a bijection, so distinct k-mers never share a hash
+inline nstring_t mix_hash(nstring_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+bool by_hash(const minimizer_t& a, const minimizer_t& b) {
+    if (a.str != b.str) return a.str < b.str;
+    return a.pos < b.pos;
+}
+
+Sketch::Sketch(int klen, int ssize) : kmer_len(klen), sketch_size(ssize), hashes(64) {
+    assert(klen > 0 && klen <= MAX_NSTRING_LEN);
+    assert(ssize > 0 && ssize <= USHRT_MAX);
+}
+
+void Sketch::calculate_and_store(const ReadStore& reads, ThreadPool* pool, unsigned int first_read) {
+
+    unsigned int n = reads.size() - first_read;
+    unsigned int blocks = std::min(n, SKETCH_BLOCKS);
+    hashes.set_blocks(blocks);
+    sketches.resize(reads.size());
+
+    std::vector<std::future<void>> results;
+    for (unsigned int b = 0; b < blocks; ++b) {
+        results.push_back(pool->enqueue([this, &reads, first_read, n, blocks, b] () {
+            static thread_local std::vector<minimizer_t> container;
+            static thread_local std::vector<char> codes;
+
+            unsigned int first = first_read + (unsigned long long) n * b / blocks;
+            unsigned int last = first_read + (unsigned long long) n * (b + 1) / blocks;
+
+            for (unsigned int i = first; i < last; ++i) {
+                container.clear();
+                const Read read = reads.get(i, codes);
+                calculate_and_get(container, read.codes, read.length);
+                sketches[i].clear();
+                for (const minimizer_t& m : container) {
+                    hashes.add_to_block(b, m.str, i, m.pos, m.forward);
+                    sketches[i].push_back(m.str);
+                }
+            }
+        }));
+    }
+
+    for (unsigned int b = 0; b < blocks; ++b) {
+        results[b].get();
+    }
+}
+
+void Sketch::calculate_and_get(std::vector<minimizer_t>& container, const char *codes, int len) {
+
+    if (len < kmer_len) return;
+
+    static thread_local std::vector<minimizer_t> kmers;
+    kmers.clear();
+
+    NucleoBuffer buff(kmer_len);
+    KmerIterator<NucleoBuffer> it(buff, codes, len);
+    while (it.next()) {
+        bool forward;
+        nstring_t kmer = buff.get_canonical_content(&forward);
+        minimizer_t m;
+        m.str = mix_hash(kmer);
+        m.pos = it.pos();
+        m.forward = forward;
+        kmers.push_back(m);
+    }
+
+    // every hash once, at its first position, and then the smallest ones of them
+    std::sort(kmers.begin(), kmers.end(), by_hash);
+
+    int kept = 0;
+    for (size_t i = 0; i < kmers.size() && kept < sketch_size; ++i) {
+        if (i > 0 && kmers[i].str == kmers[i - 1].str) continue;
+        container.push_back(kmers[i]);
+        ++kept;
+    }
+}
+
+void Sketch::freeze(ThreadPool* pool) {
+    hashes.freeze(pool);
+}
+
+void Sketch::mask(unsigned int max_occurrences) {
+    hashes.mask(max_occurrences);
+}
+
+const MinimizerIndex& Sketch::get_minimizers() const {
+    return hashes;
+}
+
+int Sketch::get_minimizer_len() const {
+    return kmer_len;
+}
+
+int Sketch::get_sketch_size() const {
+    return sketch_size;
+}
+
+double Sketch::jaccard(const std::vector<nstring_t>& a, const std::vector<nstring_t>& b) const {
+
+    // walks the smallest hashes of both sketches together, in order
+    size_t i = 0, j = 0;
+    int taken = 0, shared = 0;
+    while (taken < sketch_size && (i < a.size() || j < b.size())) {
+        if (j == b.size() || (i < a.size() && a[i] < b[j])) {
+            ++i;
+        } else if (i == a.size() || b[j] < a[i]) {
+            ++j;
+        } else {
+            ++shared;
+            ++i;
+            ++j;
+        }
+        ++taken;
+    }
+
+    return taken > 0 ? (double) shared / taken : 0.;
+}
@@ -0,0 +1,49 @@
+#ifndef SKETCH_H
+#define SKETCH_H
+
+#include <vector>
+#include "../minimizer/minimizer.h"
+#include "../minimizer_index/minimizer_index.h"
+#include "../read_store/read_store.h"
+
+class ThreadPool;
+
+// MinHash (bottom-k) sketches, an alternative to minimizers for seeding noisy reads, like
+// MHAP does. Canonical k-mers are hashed by an invertible mix of their bits, and the sketch of
+// a read holds its sketch_size smallest distinct hashes. Seeds come out as
+// minimizer_t (str is the hash) and go to a MinimizerIndex over hashes, so that lookups and
+// anchors work the way they do for minimizers.
+class Sketch {
+ public:
+     explicit Sketch(int kmer_len, int sketch_size);
+     // sketches the reads of the store from first on, read i under index i; blocks of reads
+     // are unpacked and done in parallel on the pool
+     void calculate_and_store(const ReadStore& reads, ThreadPool* pool, unsigned int first = 0);
+     // appends the sketch of the 2-bit codes to container, in order of hash
+     void calculate_and_get(std::vector<minimizer_t>& container, const char *codes, int len);
+     // builds the index from everything stored so far, has to be called before get_minimizers
+     void freeze(ThreadPool* pool = NULL);
+     // see MinimizerIndex::mask
+     void mask(unsigned int max_occurrences);
+     const MinimizerIndex& get_minimizers() const;
+     // k-mer length, the length of an anchor
+     int get_minimizer_len() const;
+     int get_sketch_size() const;
+
+     // hashes of the sketch of a stored read, in order
+     const std::vector<nstring_t>& sketch_of(unsigned int read) const {
+         return sketches[read];
+     }
+
+     // Jaccard similarity of two reads estimated from their sketches (hashes in order), the
+     // bottom-k way: the share of the sketch_size smallest hashes of both sketches together
+     // that are in both of them
+     double jaccard(const std::vector<nstring_t>& a, const std::vector<nstring_t>& b) const;
+
+ private:
+     int kmer_len;
+     int sketch_size;
+     std::vector<std::vector<nstring_t>> sketches;
+     MinimizerIndex hashes;
+};
+#endif
@@ -0,0 +1,178 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <set>
+#include "./sketch.h"
+#include "../encode/encode.h"
+#include "thread_pool/ThreadPool.h"
+
+std::string random_read(int len) {
+    std::string str(len, 'A');
+    for (int i = 0; i < len; ++i) {
+        str[i] = "ACGT"[rand() % 4];
+    }
+    return str;
+}
+
+std::string reverse_complement(const std::string& str) {
+    std::string rc(str.rbegin(), str.rend());
+    for (char& c : rc) {
+        c = c == 'A' ? 'T' : c == 'C' ? 'G' : c == 'G' ? 'C' : 'A';
+    }
+    return rc;
+}
+
+std::vector<minimizer_t> sketch_of(Sketch& sketch, const std::string& str) {
+    std::vector<char> codes(str.size() + 1);
+    encode_bases(str.c_str(), str.size(), &codes[0]);
+
+    std::vector<minimizer_t> container;
+    sketch.calculate_and_get(container, &codes[0], str.size());
+    return container;
+}
+
+// distinct hashes, in order, at most sketch_size of them and the smallest ones of the read
+void test_bottom_k() {
+    Sketch sketch(12, 64);
+
+    std::string read = random_read(2000);
+    auto hashes = sketch_of(sketch, read);
+    assert(hashes.size() <= 64 && hashes.size() > 60);
+    for (size_t i = 1; i < hashes.size(); ++i) {
+        assert(hashes[i - 1].str < hashes[i].str);
+    }
+
+    // a prefix of the read has no hash below the largest one the read keeps that the read does not
+    auto prefix = sketch_of(sketch, read.substr(0, 1000));
+    std::set<nstring_t> kept;
+    for (auto& m : hashes) kept.insert(m.str);
+    for (auto& m : prefix) {
+        if (m.str <= hashes.back().str) assert(kept.count(m.str));
+    }
+
+    // shorter than a k-mer, and a single repeated base
+    assert(sketch_of(sketch, "ACGT").empty());
+    assert(sketch_of(sketch, std::string(500, 'A')).size() == 1);
+
+    // repeated k-mers count once, so a repetitive read still gets a full sketch, the same
+    // as the one of a single copy of the repeat
+    std::string unit = random_read(300);
+    std::string repeats = unit + unit + unit + unit + unit;
+    auto repeated = sketch_of(sketch, repeats);
+    assert(repeated.size() == 64);
+    for (size_t i = 1; i < repeated.size(); ++i) {
+        assert(repeated[i - 1].str < repeated[i].str);
+    }
+    auto single = sketch_of(sketch, unit + unit.substr(0, 11));
+    for (size_t i = 0; i < single.size(); ++i) {
+        assert(single[i].str == repeated[i].str);
+    }
+}
+
+// the share of the smallest hashes of both sketches together that are in both
+void test_jaccard() {
+    Sketch sketch(12, 4);
+
+    std::vector<nstring_t> a = { 1, 2, 3, 4 }, b = { 2, 3, 4, 5 }, c = { 5, 6, 7, 8 };
+    assert(sketch.jaccard(a, a) == 1.);
+    // 1, 2, 3 and 4 are the smallest ones, 2, 3 and 4 are in both
+    assert(sketch.jaccard(a, b) == 0.75);
+    assert(sketch.jaccard(b, a) == 0.75);
+    assert(sketch.jaccard(a, c) == 0.);
+    assert(sketch.jaccard(a, std::vector<nstring_t>()) == 0.);
+    assert(sketch.jaccard(std::vector<nstring_t>(), std::vector<nstring_t>()) == 0.);
+
+    // shorter sketches of short reads: 1, 2 and 9 are all there is
+    std::vector<nstring_t> d = { 1, 9 }, e = { 2, 9 };
+    assert(sketch.jaccard(d, e) == 1. / 3);
+
+    // close to the Jaccard similarity of the k-mer sets of overlapping reads; k-mers of the
+    // genome are distinct, so a read of 3000 bases sharing 1500 with another has 1500 - 11
+    // of the 3000 - 11 + 1500 k-mers of both
+    Sketch large(12, 1000);
+    std::string genome = random_read(4500);
+    auto one = sketch_of(large, genome.substr(0, 3000)), two = sketch_of(large, genome.substr(1500, 3000));
+    std::vector<nstring_t> one_hashes, two_hashes;
+    for (auto& m : one) one_hashes.push_back(m.str);
+    for (auto& m : two) two_hashes.push_back(m.str);
+
+    double expected = (1500. - 11) / (3000 - 11 + 1500);
+    double estimate = large.jaccard(one_hashes, two_hashes);
+    assert(estimate > expected - 0.06 && estimate < expected + 0.06);
+}
+
+// the reverse complement has the same hashes, from the other strand and at mirrored positions
+void test_strands() {
+    Sketch sketch(15, 100);
+
+    std::string read = random_read(1000);
+    auto forward = sketch_of(sketch, read);
+    auto reverse = sketch_of(sketch, reverse_complement(read));
+
+    assert(forward.size() == reverse.size());
+    for (size_t i = 0; i < forward.size(); ++i) {
+        assert(forward[i].str == reverse[i].str);
+        assert(forward[i].forward != reverse[i].forward);
+        assert(forward[i].pos + reverse[i].pos + 15 == read.size());
+    }
+}
+
+// overlapping reads share hashes in the index, unrelated ones almost never
+void test_index(ThreadPool* pool) {
+    Sketch sketch(16, 200);
+    ReadStore reads;
+
+    srand(7);
+    std::string genome = random_read(5000);
+    std::string one = genome.substr(0, 3000), two = genome.substr(1500, 3000), other = random_read(3000);
+    reads.add(0, one.c_str(), one.size());
+    reads.add(1, two.c_str(), two.size());
+    reads.add(2, other.c_str(), other.size());
+
+    sketch.calculate_and_store(reads, pool);
+    sketch.freeze(pool);
+    assert(sketch.sketch_of(0).size() == 200 && sketch.sketch_of(2).size() == 200);
+
+    std::vector<unsigned int> shared(3, 0);
+    for (auto& m : sketch_of(sketch, one)) {
+        auto list = sketch.get_minimizers().get_list(m.str);
+        for (auto p = list.begin(); p != list.end(); ++p) {
+            ++shared[p->read];
+            // the same k-mer, so the same offset into the genome
+            if (p->read == 1) assert(m.pos == (unsigned int) p->pos + 1500);
+        }
+    }
+
+    assert(shared[0] == 200);
+    assert(sketch.jaccard(sketch.sketch_of(0), sketch.sketch_of(0)) == 1.);
+    assert(shared[1] > 20);
+    assert(sketch.jaccard(sketch.sketch_of(0), sketch.sketch_of(1)) > 0.05);
+    assert(shared[2] <= 1);
+    assert(sketch.jaccard(sketch.sketch_of(0), sketch.sketch_of(2)) < 0.02);
+}
+
+int main() {
+
+    srand(1);
+    ThreadPool pool(4);
+
+    printf("bottom k test: ");
+    test_bottom_k();
+    printf("OK\n");
+
+    printf("jaccard test: ");
+    test_jaccard();
+    printf("OK\n");
+
+    printf("strands test: ");
+    test_strands();
+    printf("OK\n");
+
+    printf("index test: ");
+    test_index(&pool);
+    printf("OK\n");
+
+    return 0;
+}
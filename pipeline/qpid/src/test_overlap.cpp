@@ -0,0 +1,114 @@
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "lib/ovb/ovb.h"
+
+// Runs bin/overlap on generated reads, so it has to be run from the qpid directory.
+
+// path of a new empty file
+std::string temp_file() {
+    char path[] = "/tmp/test_overlap_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    return path;
+}
+
+std::string random_read(int len) {
+    std::string str(len, 'A');
+    for (int i = 0; i < len; ++i) {
+        str[i] = "ACGT"[rand() % 4];
+    }
+    return str;
+}
+
+std::string reverse_complement(const std::string& str) {
+    std::string rc(str.rbegin(), str.rend());
+    for (char& c : rc) {
+        c = c == 'A' ? 'T' : c == 'C' ? 'G' : c == 'G' ? 'C' : 'A';
+    }
+    return rc;
+}
+
+void write_afg(const std::string& path, const std::vector<std::string>& reads) {
+    FILE* fd = fopen(path.c_str(), "w");
+    for (int i = 0, len = reads.size(); i < len; ++i) {
+        fprintf(fd, "{RED\niid:%d\neid:%d\nseq:\n%s\n.\nqlt:\n%s\n.\nclr:0,%d\n}\n", i + 1, i + 1,
+            reads[i].c_str(), std::string(reads[i].size(), 'X').c_str(), (int) reads[i].size());
+    }
+    fclose(fd);
+}
+
+// With -c, reads identical to an earlier one are not overlapped, but the header counts them.
+// Every copy gets a single record, contained in the first read with no hangs, normal for
+// a copy and innie for a reversed one, and no other record.
+void test_collapsed_binary() {
+    srand(3);
+
+    // overlapping reads of a genome, every third of them copied, some of the copies reversed
+    std::string genome = random_read(3000);
+    std::vector<std::string> reads;
+    // by iid: iid of the first read, 'N' or 'I' for copies, 0 for the first reads
+    std::vector<int> first(1, 0);
+    std::vector<char> adj(1, 0);
+    int distinct = 0;
+    for (int start = 0; start + 400 <= (int) genome.size(); start += 150) {
+        std::string read = genome.substr(start, 400);
+        reads.push_back(read);
+        first.push_back(reads.size());
+        adj.push_back(0);
+        ++distinct;
+        if (distinct % 3 == 0) {
+            int iid = reads.size();
+            reads.push_back(read);
+            first.push_back(iid);
+            adj.push_back('N');
+            reads.push_back(reverse_complement(read));
+            first.push_back(iid);
+            adj.push_back('I');
+        }
+    }
+
+    std::string afg = temp_file(), ovb = temp_file();
+    write_afg(afg, reads);
+
+    std::string command = "./bin/overlap -c -b -o " + ovb + " " + afg + " 2> /dev/null";
+    assert(system(command.c_str()) == 0);
+
+    OVB::Reader reader;
+    assert(reader.open(ovb.c_str()) == 0);
+    assert(reader.verify());
+    assert(reader.header().reads == reads.size());
+    assert(reader.size() > 0);
+
+    std::vector<int> records(reads.size() + 1, 0);
+    for (uint64_t i = 0; i < reader.size(); ++i) {
+        OVB::Overlap overlap = reader.get(i);
+        int one = overlap.read_one, two = overlap.read_two;
+
+        if (adj[one] != 0) {
+            assert(two == first[one] && adj[two] == 0);
+            assert(overlap.adj == adj[one] && overlap.a_hang == 0 && overlap.b_hang == 0);
+            assert(overlap.score == (int) reads[one - 1].size());
+            ++records[one];
+        }
+        assert(adj[two] == 0);
+    }
+    for (int iid = 1, len = reads.size(); iid <= len; ++iid) {
+        if (adj[iid] != 0) assert(records[iid] == 1);
+    }
+    reader.close();
+
+    unlink(afg.c_str());
+    unlink(ovb.c_str());
+}
+
+int main() {
+    test_collapsed_binary();
+
+    printf("test_overlap passed\n");
+    return 0;
+}